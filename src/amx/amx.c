@@ -32,6 +32,13 @@
  * - LCTRL 0xFF always sets PRI to 1
  * - Long call detection
  * - Detection of writes to address 0 (a.k.a "address naught" detection)
+ * - Optional execution history of taken branches, calls and returns
+ * - Optional data watchpoints (the host is notified of stores to watched cells)
+ * - Optional heap change notifications (for the heap allocation profiler)
+ * - Optional instruction counting with function entry and exit notifications
+ * - The optional hooks above are implemented by a second copy of amx_Exec(),
+ *   amx_ExecInstrumented() (see amxexecinstr.c), that amx_Exec() switches to
+ *   only when the host has enabled one of them
  */
 
 #if BUILD_PLATFORM == WINDOWS && BUILD_TYPE == RELEASE && BUILD_COMPILER == MSVC && PAWN_CELL_SIZE == 64
@@ -76,11 +83,11 @@
 #endif
 
 /* CheckLongCallTime uses the values in `amx`, but while we're in `Exec`
- * they aren't accurate.
+ * they aren't accurate. The instruction counter is local to each amx_Exec()
+ * call so that scripts may run in more than one thread.
  */
-static unsigned int long_call_delay=0;
-static void checkLongCallTime(AMX *amx, AMX_LCT_CTL long_call_ctl, cell frm, cell hea, cell stk) {
-  if (long_call_delay>=5000) {
+static void checkLongCallTime(AMX *amx, AMX_LCT_CTL long_call_ctl, unsigned int *long_call_delay, cell frm, cell hea, cell stk) {
+  if (*long_call_delay>=5000) {
     if (long_call_ctl!=NULL) {
       cell tmp_frm=amx->frm;
       cell tmp_hea=amx->hea;
@@ -93,11 +100,38 @@ static void checkLongCallTime(AMX *amx, AMX_LCT_CTL long_call_ctl, cell frm, cel
       amx->hea=tmp_hea;
       amx->stk=tmp_stk;
     }
-    long_call_delay=0;
+    *long_call_delay=0;
   }
 }
 
+#if defined AMX_EXEC_INSTRUMENTED
+/* Same as above: sync the registers so that the host sees the current frame
+ * when it inspects the watched data (and builds a backtrace).
+ */
+static int checkWatch(AMX *amx, AMX_WATCH *watch, cell address, cell size, cell frm, cell hea, cell stk) {
+  int result=AMX_ERR_NONE;
+  if (watch->callback!=NULL) {
+    cell tmp_frm=amx->frm;
+    cell tmp_hea=amx->hea;
+    cell tmp_stk=amx->stk;
+    amx->frm=frm;
+    amx->hea=hea;
+    amx->stk=stk;
+    result=watch->callback(amx,address,size);
+    amx->frm=tmp_frm;
+    amx->hea=tmp_hea;
+    amx->stk=tmp_stk;
+  }
+  return result;
+}
+
+/* insn_count points to a dummy local when metering is off, which is cheaper
+ * than testing for it on every instruction
+ */
+#define CHECK_LONG_CALL_TIME() (++long_call_delay, ++*insn_count)
+#else
 #define CHECK_LONG_CALL_TIME() (++long_call_delay)
+#endif
 
 /* When one or more of the AMX_funcname macris are defined, we want
  * to compile only those functions. However, when none of these macros
@@ -124,7 +158,7 @@ static void checkLongCallTime(AMX *amx, AMX_LCT_CTL long_call_ctl, cell frm, cel
 #if defined AMX_XXXSTRING  || defined AMX_XXXTAGS     || defined AMX_XXXUSERDATA
   #define AMX_EXPLIT_FUNCTIONS
 #endif
-#if defined AMX_UTF8XXX
+#if defined AMX_UTF8XXX     || defined AMX_EXEC_INSTRUMENTED
   #define AMX_EXPLIT_FUNCTIONS
 #endif
 #if !defined AMX_EXPLIT_FUNCTIONS
@@ -1625,10 +1659,11 @@ AMX_NATIVE_INFO * AMXAPI amx_NativeInfo(const char *name, AMX_NATIVE func)
 }
 #endif /* AMX_NATIVEINFO */
 
-#if defined AMX_EXEC || defined AMX_INIT
+#if defined AMX_EXEC || defined AMX_INIT || defined AMX_EXEC_INSTRUMENTED
 
 #define STKMARGIN       ((cell)(16*sizeof(cell)))
 
+#if defined AMX_EXEC || defined AMX_INIT
 int AMXAPI amx_Push(AMX *amx, cell value)
 {
   AMX_HEADER *hdr;
@@ -1688,6 +1723,7 @@ int AMXAPI amx_PushString(AMX *amx, cell *amx_addr, cell **phys_addr, const char
   } /* if */
   return err;
 }
+#endif /* AMX_EXEC || AMX_INIT */
 
 #if defined AMX_XXXUSERDATA
 int AMXAPI amx_RaiseExecError(AMX *amx, cell index, cell *retval, int error)
@@ -1742,7 +1778,84 @@ int AMXAPI amx_SetExtHooks(AMX *amx, AMX_EXT_HOOKS *ext_hooks)
 #define CHKSTACK()      if (stk>amx->stp) ABORT(amx, AMX_ERR_STACKLOW)
 #define CHKHEAP()       if (hea<amx->hlw) ABORT(amx, AMX_ERR_HEAPLOW)
 
-#if (defined __GNUC__ && !defined __MINGW32__) && !(defined ASM32 || defined JIT)
+#if defined AMX_EXEC_INSTRUMENTED
+
+/* record a control transfer from the current instruction to "target" in the
+ * execution history ring (if the host has enabled it)
+ */
+#define RECORD_HISTORY(target) \
+  do { \
+    if (exec_history!=NULL) { \
+      cell *entry_=exec_history->entries \
+                   +2*(exec_history->next++ & exec_history->mask); \
+      entry_[0]=amx->cip; \
+      entry_[1]=(cell)((unsigned char *)(target)-code); \
+    } \
+  } while (0)
+
+/* notify the host of a store to [addr, addr+size) if it overlaps any of the
+ * watched cells; natives may write anywhere and may also add watchpoints, so
+ * after a native call the watch list is re-read and checked as a whole
+ */
+#define CHKWATCH(addr,size) \
+  do { \
+    if (watch!=NULL && (addr)<watch->upper && (addr)+(size)>watch->lower \
+        && (num=checkWatch(amx,watch,(addr),(size),frm,hea,stk))!=AMX_ERR_NONE) \
+      ABORT(amx,num); \
+  } while (0)
+#define CHKWATCH_NATIVE() \
+  do { \
+    if (ext_hooks!=NULL) \
+      watch=ext_hooks->watch; \
+    if (watch!=NULL \
+        && (num=checkWatch(amx,watch,0,0,frm,hea,stk))!=AMX_ERR_NONE) \
+      ABORT(amx,num); \
+  } while (0)
+
+/* tell the host that the heap top moved from "from" to "to" at the current
+ * (HEAP) instruction
+ */
+#define CHKHEAPCTL(from,to) \
+  do { \
+    if (heap_ctl!=NULL \
+        && (num=heap_ctl(amx,(cell)((unsigned char *)cip-code)-2*sizeof(cell), \
+                         (from),(to)))!=AMX_ERR_NONE) \
+      ABORT(amx,num); \
+  } while (0)
+
+/* notify the host that a function is entered or left at the instruction
+ * that starts at "addr"
+ */
+#define METER_EVENT(event,addr) \
+  do { \
+    if (meter!=NULL && meter->callback!=NULL \
+        && (num=meter->callback(amx,(event),(addr)))!=AMX_ERR_NONE) \
+      ABORT(amx,num); \
+  } while (0)
+
+#else
+
+#define RECORD_HISTORY(target)  ((void)0)
+#define CHKWATCH(addr,size)     ((void)0)
+#define CHKWATCH_NATIVE()       ((void)0)
+#define CHKHEAPCTL(from,to)     ((void)0)
+#define METER_EVENT(event,addr) ((void)0)
+
+/* the hooks that need the instrumented copy of the interpreter loop */
+#define USES_INSTRUMENTED_EXEC(ext_hooks) \
+  ((ext_hooks)->exec_history!=NULL || (ext_hooks)->watch!=NULL \
+   || (ext_hooks)->heap_ctl!=NULL || (ext_hooks)->meter!=NULL)
+
+int AMXAPI amx_ExecInstrumented(AMX *amx, cell *retval, int index);
+#if defined __GNUC__ && !defined __MINGW32__
+  void amx_InitOpcodeMap(const cell *opcode_list);
+#endif
+
+#endif /* AMX_EXEC_INSTRUMENTED */
+
+#define JUMPTO(cip)     do { cip=JUMPABS(code, cip); RECORD_HISTORY(cip); } while (0)
+
+#if (defined __GNUC__ && !defined __MINGW32__) && !(defined ASM32 || defined JIT) && !defined AMX_EXEC_INSTRUMENTED
     /* GNU C version uses the "labels as values" extension to create
      * fast "indirect threaded" interpreter.
      */
@@ -1798,6 +1911,7 @@ static const void * const amx_opcodelist[] = {
   AMX_EXT_HOOKS *ext_hooks=NULL;
   AMX_LCT_CTL long_call_ctl=NULL;
   AMX_ADDR_0_CTL address_naught_ctl=NULL;
+  unsigned int long_call_delay=0;
 
   /* HACK: return label table (for amx_BrowseRelocate) if amx structure
    * has the AMX_FLAG_BROWSE flag set.
@@ -1807,6 +1921,7 @@ static const void * const amx_opcodelist[] = {
     assert(sizeof(cell)==sizeof(void *));
     assert(retval!=NULL);
     *retval=(cell)amx_opcodelist;
+    amx_InitOpcodeMap((const cell *)amx_opcodelist);
     return 0;
   } /* if */
 
@@ -1818,6 +1933,10 @@ static const void * const amx_opcodelist[] = {
     return AMX_ERR_INIT;
   assert((amx->flags & AMX_FLAG_BROWSE)==0);
 
+  amx_GetExtHooks(amx,&ext_hooks);
+  if (ext_hooks!=NULL && USES_INSTRUMENTED_EXEC(ext_hooks))
+    return amx_ExecInstrumented(amx,retval,index);
+
   /* set up the registers */
   hdr=(AMX_HEADER *)amx->base;
   assert(hdr->magic==AMX_MAGIC);
@@ -2712,7 +2831,7 @@ static const void * const amx_opcodelist[] = {
   op_break:
     if (amx->debug!=NULL) {
       /* only checked at the ends of statements */
-      checkLongCallTime(amx, long_call_ctl, frm, hea, stk);
+      checkLongCallTime(amx, long_call_ctl, &long_call_delay, frm, hea, stk);
       /* store status */
       amx->frm=frm;
       amx->stk=stk;
@@ -2767,7 +2886,60 @@ static const void * const amx_opcodelist[] = {
   #endif
 #endif
 
+#if defined AMX_EXEC_INSTRUMENTED && (defined __GNUC__ && !defined __MINGW32__)
+/* The code was relocated for the "indirect threaded" version of amx_Exec(),
+ * so every opcode is the address of a label in that function. This table maps
+ * those addresses back to opcode numbers; it is sorted on address and filled
+ * in when amx_Exec() hands out its label table (before any code can run).
+ */
+static struct {
+  ucell address;
+  OPCODE op;
+} opcode_map[OP_NUM_OPCODES];
+static int opcode_map_ready=0;
+
+void amx_InitOpcodeMap(const cell *opcode_list)
+{
+  int i,j;
+
+  if (opcode_map_ready)
+    return;
+  /* insertion sort, the list is short */
+  for (i=0; i<OP_NUM_OPCODES; i++) {
+    for (j=i; j>0 && opcode_map[j-1].address>(ucell)opcode_list[i]; j--)
+      opcode_map[j]=opcode_map[j-1];
+    opcode_map[j].address=(ucell)opcode_list[i];
+    opcode_map[j].op=(OPCODE)i;
+  } /* for */
+  opcode_map_ready=1;
+}
+
+static OPCODE decodeOpcode(ucell address)
+{
+  int low=0,high=OP_NUM_OPCODES-1,mid;
+
+  while (low<=high) {
+    mid=(low+high)/2;
+    if (opcode_map[mid].address<address)
+      low=mid+1;
+    else if (opcode_map[mid].address>address)
+      high=mid-1;
+    else
+      return opcode_map[mid].op;
+  } /* while */
+  return OP_NONE;       /* aborts with AMX_ERR_INVINSTR */
+}
+
+#define FETCHOP(cip)    decodeOpcode((ucell)*(cip)++)
+#else
+#define FETCHOP(cip)    ((OPCODE) *(cip)++)
+#endif
+
+#if defined AMX_EXEC_INSTRUMENTED
+int AMXAPI amx_ExecInstrumented(AMX *amx, cell *retval, int index)
+#else
 int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
+#endif
 {
   AMX_HEADER *hdr;
   AMX_FUNCSTUB *func;
@@ -2798,6 +2970,15 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
   AMX_EXT_HOOKS *ext_hooks=NULL;
   AMX_LCT_CTL long_call_ctl=NULL;
   AMX_ADDR_0_CTL address_naught_ctl=NULL;
+  #if defined AMX_EXEC_INSTRUMENTED
+    AMX_EXEC_HISTORY *exec_history=NULL;
+    AMX_WATCH *watch=NULL;
+    AMX_HEAP_CTL heap_ctl=NULL;
+    AMX_METER *meter=NULL;
+    ucell insn_dummy;
+    ucell *insn_count=&insn_dummy;
+  #endif
+  unsigned int long_call_delay=0;
 
   assert(amx!=NULL);
   #if defined ASM32 || defined JIT
@@ -2829,6 +3010,12 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
     return AMX_ERR_INIT;
   assert((amx->flags & AMX_FLAG_BROWSE)==0);
 
+  #if !defined AMX_EXEC_INSTRUMENTED && !(defined ASM32 || defined JIT)
+    amx_GetExtHooks(amx,&ext_hooks);
+    if (ext_hooks!=NULL && USES_INSTRUMENTED_EXEC(ext_hooks))
+      return amx_ExecInstrumented(amx,retval,index);
+  #endif
+
   /* set up the registers */
   hdr=(AMX_HEADER *)amx->base;
   assert(hdr->magic==AMX_MAGIC);
@@ -2907,6 +3094,18 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
     long_call_ctl=ext_hooks->long_call_ctl;
   if (ext_hooks!=NULL)
     address_naught_ctl=ext_hooks->address_naught_ctl;
+  #if defined AMX_EXEC_INSTRUMENTED
+    if (ext_hooks!=NULL)
+      exec_history=ext_hooks->exec_history;
+    if (ext_hooks!=NULL)
+      watch=ext_hooks->watch;
+    if (ext_hooks!=NULL)
+      heap_ctl=ext_hooks->heap_ctl;
+    if (ext_hooks!=NULL && ext_hooks->meter!=NULL) {
+      meter=ext_hooks->meter;
+      insn_count=&meter->count;
+    }
+  #endif
 
   /* start running */
 #if defined ASM32 || defined JIT
@@ -2950,7 +3149,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
   for (;;) {
     amx->cip=(cell)((unsigned char *)cip-code);
     CHECK_LONG_CALL_TIME();
-    op=(OPCODE) *cip++;
+    op=FETCHOP(cip);
     switch (op) {
     case OP_LOAD_PRI:
       GETPARAM(offs);
@@ -3034,12 +3233,14 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=pri;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_STOR_ALT:
       GETPARAM(offs);
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=alt;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_STOR_S_PRI:
       GETPARAM(offs);
@@ -3061,6 +3262,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=pri;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_SREF_ALT:
       amx->frm = frm;
@@ -3070,6 +3272,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=alt;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_SREF_S_PRI:
       GETPARAM(offs);
@@ -3077,6 +3280,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=pri;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_SREF_S_ALT:
       GETPARAM(offs);
@@ -3084,6 +3288,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)offs==0)
         CHKNAUGHT();
       *(cell *)(data+(int)offs)=alt;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_STOR_I:
       /* verify address */
@@ -3092,6 +3297,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((int)alt==0)
         CHKNAUGHT();
       *(cell *)(data+(int)alt)=pri;
+      CHKWATCH(alt,sizeof(cell));
       break;
     case OP_STRB_I:
       GETPARAM(offs);
@@ -3111,6 +3317,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         *(uint32_t *)(data+(int)alt)=(uint32_t)pri;
         break;
       } /* switch */
+      CHKWATCH(alt,offs);
       break;
     case OP_LIDX:
       offs=pri*sizeof(cell)+alt;
@@ -3296,21 +3503,26 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       hea+=offs;
       CHKMARGIN();
       CHKHEAP();
+      CHKHEAPCTL(alt,hea);
       break;
     case OP_PROC:
+      METER_EVENT(AMX_METER_ENTER,amx->cip);
       PUSH(frm);
       frm=stk;
       CHKMARGIN();
       break;
     case OP_RET:
+      METER_EVENT(AMX_METER_LEAVE,amx->cip);
       POP(frm);
       POP(offs);
       /* verify the return address */
       if ((ucell)offs>=codesize)
         ABORT(amx,AMX_ERR_MEMACCESS);
       cip=(cell *)(code+(int)offs);
+      RECORD_HISTORY(cip);
       break;
     case OP_RETN:
+      METER_EVENT(AMX_METER_LEAVE,amx->cip);
       POP(frm);
       POP(offs);
       /* verify the return address */
@@ -3319,89 +3531,91 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       cip=(cell *)(code+(int)offs);
       stk+= *(cell *)(data+(int)stk) + sizeof(cell); /* remove parameters from the stack */
       amx->stk=stk;
+      RECORD_HISTORY(cip);
       break;
     case OP_CALL:
       PUSH(((unsigned char *)cip-code)+sizeof(cell));/* skip address */
-      cip=JUMPABS(code, cip);                   /* jump to the address */
+      JUMPTO(cip);                              /* jump to the address */
       break;
     case OP_JUMP:
       /* since the GETPARAM() macro modifies cip, you cannot
        * do GETPARAM(cip) directly */
-      cip=JUMPABS(code, cip);
+      JUMPTO(cip);
       break;
     case OP_JREL:
       offs=*cip;
       cip=(cell *)((unsigned char *)cip + (int)offs + sizeof(cell));
+      RECORD_HISTORY(cip);
       break;
     case OP_JZER:
       if (pri==0)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JNZ:
       if (pri!=0)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JEQ:
       if (pri==alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JNEQ:
       if (pri!=alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JLESS:
       if ((ucell)pri < (ucell)alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JLEQ:
       if ((ucell)pri <= (ucell)alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JGRTR:
       if ((ucell)pri > (ucell)alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JGEQ:
       if ((ucell)pri >= (ucell)alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JSLESS:
       if (pri<alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JSLEQ:
       if (pri<=alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JSGRTR:
       if (pri>alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
     case OP_JSGEQ:
       if (pri>=alt)
-        cip=JUMPABS(code, cip);
+        JUMPTO(cip);
       else
         cip=(cell *)((unsigned char *)cip+sizeof(cell));
       break;
@@ -3514,6 +3728,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
     case OP_ZERO:
       GETPARAM(offs);
       *(cell *)(data+(int)offs)=0;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_ZERO_S:
       GETPARAM(offs);
@@ -3574,6 +3789,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
     case OP_INC:
       GETPARAM(offs);
       *(cell *)(data+(int)offs) += 1;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_INC_S:
       GETPARAM(offs);
@@ -3581,6 +3797,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       break;
     case OP_INC_I:
       *(cell *)(data+(int)pri) += 1;
+      CHKWATCH(pri,sizeof(cell));
       break;
     case OP_DEC_PRI:
       pri--;
@@ -3591,6 +3808,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
     case OP_DEC:
       GETPARAM(offs);
       *(cell *)(data+(int)offs) -= 1;
+      CHKWATCH(offs,sizeof(cell));
       break;
     case OP_DEC_S:
       GETPARAM(offs);
@@ -3598,6 +3816,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       break;
     case OP_DEC_I:
       *(cell *)(data+(int)pri) -= 1;
+      CHKWATCH(pri,sizeof(cell));
       break;
     case OP_MOVS:
       GETPARAM(offs);
@@ -3613,6 +3832,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       if ((alt+offs)>hea && (alt+offs)<stk || (ucell)(alt+offs)>(ucell)amx->stp)
         ABORT(amx,AMX_ERR_MEMACCESS);
       memcpy(data+(int)alt, data+(int)pri, (int)offs);
+      CHKWATCH(alt,offs);
       break;
     case OP_CMPS:
       GETPARAM(offs);
@@ -3638,6 +3858,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         ABORT(amx,AMX_ERR_MEMACCESS);
       for (i=(int)alt; (size_t)offs>=sizeof(cell); i+=sizeof(cell), offs-=sizeof(cell))
         *(cell *)(data+i) = pri;
+      CHKWATCH(alt,(cell)i-alt);
       break;
     case OP_HALT:
       GETPARAM(offs);
@@ -3677,6 +3898,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         } /* if */
         ABORT(amx,num);
       } /* if */
+      CHKWATCH_NATIVE();
       break;
     case OP_SYSREQ_C:
       GETPARAM(offs);
@@ -3696,6 +3918,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         } /* if */
         ABORT(amx,num);
       } /* if */
+      CHKWATCH_NATIVE();
       break;
     case OP_SYSREQ_D:
       GETPARAM(offs);
@@ -3715,6 +3938,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         } /* if */
         ABORT(amx,amx->error);
       } /* if */
+      CHKWATCH_NATIVE();
       break;
     case OP_LINE:
       SKIPPARAM(2);
@@ -3739,6 +3963,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
         /* nothing */;
       if (num>0)
         cip=JUMPABS(code,cptr+1); /* case found */
+      RECORD_HISTORY(cip);
       break;
     } /* case */
     case OP_SWAP_PRI:
@@ -3761,7 +3986,7 @@ int AMXAPI amx_Exec(AMX *amx, cell *retval, int index)
       assert((amx->flags & AMX_FLAG_BROWSE)==0);
       if (amx->debug!=NULL) {
         /* only checked at the ends of statements */
-        checkLongCallTime(amx, long_call_ctl, frm, hea, stk);
+        checkLongCallTime(amx, long_call_ctl, &long_call_delay, frm, hea, stk);
         /* store status */
         amx->frm=frm;
         amx->stk=stk;
@@ -3847,6 +4072,14 @@ int AMXAPI amx_GetAddr(AMX *amx,cell amx_addr,cell **phys_addr)
 #endif /* AMX_GETADDR */
 
 #if defined AMX_ALLOT || defined AMX_EXEC
+static void notifyHeapChange(AMX *amx,cell from,cell to)
+{
+  AMX_EXT_HOOKS *ext_hooks;
+
+  if (amx_GetExtHooks(amx,&ext_hooks)==AMX_ERR_NONE && ext_hooks->heap_ctl!=NULL)
+    ext_hooks->heap_ctl(amx,amx->cip,from,to);
+}
+
 int AMXAPI amx_Allot(AMX *amx,int cells,cell *amx_addr,cell **phys_addr)
 {
   AMX_HEADER *hdr;
@@ -3865,13 +4098,17 @@ int AMXAPI amx_Allot(AMX *amx,int cells,cell *amx_addr,cell **phys_addr)
   *amx_addr=amx->hea;
   *phys_addr=(cell *)(data + (int)amx->hea);
   amx->hea += cells*sizeof(cell);
+  notifyHeapChange(amx,*amx_addr,amx->hea);
   return AMX_ERR_NONE;
 }
 
 int AMXAPI amx_Release(AMX *amx,cell amx_addr)
 {
-  if (amx->hea > amx_addr)
+  if (amx->hea > amx_addr) {
+    cell hea=amx->hea;
     amx->hea=amx_addr;
+    notifyHeapChange(amx,hea,amx_addr);
+  } /* if */
   return AMX_ERR_NONE;
 }
 #endif /* AMX_ALLOT */
@@ -172,6 +172,9 @@ typedef int (AMXAPI *AMX_DEBUG)(struct tagAMX *amx);
 typedef int (AMXAPI *AMX_EXEC_ERROR)(struct tagAMX *amx, int index, cell *retval, int error);
 typedef int (AMXAPI *AMX_LCT_CTL)(struct tagAMX *amx, int option, int value);
 typedef int (AMXAPI * AMX_ADDR_0_CTL)(struct tagAMX *amx, int option);
+typedef int (AMXAPI *AMX_WATCH_CTL)(struct tagAMX *amx, cell address, cell size);
+typedef int (AMXAPI *AMX_HEAP_CTL)(struct tagAMX *amx, cell cip, cell from, cell to);
+typedef int (AMXAPI *AMX_METER_CTL)(struct tagAMX *amx, int event, cell cip);
 
 #if !defined _FAR
   #define _FAR
@@ -290,14 +293,64 @@ typedef struct tagAMX_HEADER {
   int32_t nametable     PACKED; /* name table */
 } PACKED AMX_HEADER;
 
+/* The AMX_EXEC_HISTORY structure is a ring buffer that amx_Exec() fills with
+ * the most recent control transfers (taken branches, calls and returns) as
+ * pairs of source and target code addresses.
+ */
+typedef struct tagAMX_EXEC_HISTORY {
+  cell *entries;        /* 2*(mask+1) cells: source and target of each jump */
+  uint32_t mask;        /* number of entries minus one (a power of two) */
+  uint32_t next;        /* total number of entries written so far */
+} PACKED AMX_EXEC_HISTORY;
+
+/* The AMX_WATCH structure describes the data watchpoints of a script. After
+ * every store that may have touched [lower, upper) amx_Exec() calls "callback"
+ * with the address and size (in bytes) of the written memory; after a native
+ * function call it passes a size of 0, meaning that any cell may have changed.
+ * The callback returns AMX_ERR_NONE to continue execution.
+ */
+typedef struct tagAMX_WATCH {
+  cell lower;           /* lowest watched data address */
+  cell upper;           /* one past the highest watched data address */
+  AMX_WATCH_CTL callback;
+} PACKED AMX_WATCH;
+
+/* If set, AMX_HEAP_CTL is called whenever the top of the heap moves "from" one
+ * address "to" another, either by the HEAP instruction at "cip" or by
+ * amx_Allot() and amx_Release() (in which case "cip" is amx->cip). A return
+ * value other than AMX_ERR_NONE aborts execution.
+ */
+
+/* The AMX_METER structure counts the instructions executed by amx_Exec(). If
+ * "callback" is set, it is also called on entry to every function (PROC) and
+ * on return from it (RET, RETN), right after "count" has been updated, with
+ * the address of that instruction. A return value other than AMX_ERR_NONE
+ * aborts execution.
+ */
+typedef struct tagAMX_METER {
+  ucell count;          /* wraps around; use differences between readings */
+  AMX_METER_CTL callback;
+} PACKED AMX_METER;
+
+#define AMX_METER_ENTER 0
+#define AMX_METER_LEAVE 1
+
 /* The AMX_EXT_HOOKS structure is a custom extension for CrashDetect that lets
  * the host (e.g. the CrashDetect plugin) to hook into certain AMX execution
  * events.
+ *
+ * If any of exec_history, watch, heap_ctl or meter is set when amx_Exec() is
+ * called, the code runs in a slower, instrumented interpreter loop. Setting
+ * one of them while the script is running takes effect on the next call.
  */
 typedef struct tagAMX_EXT_HOOKS {
   AMX_EXEC_ERROR exec_error;
   AMX_LCT_CTL long_call_ctl;
   AMX_ADDR_0_CTL address_naught_ctl;
+  AMX_EXEC_HISTORY *exec_history; /* may be NULL */
+  AMX_WATCH *watch;               /* may be NULL */
+  AMX_HEAP_CTL heap_ctl;          /* may be NULL */
+  AMX_METER *meter;               /* may be NULL */
 } PACKED AMX_EXT_HOOKS;
 
 #if PAWN_CELL_SIZE==16
@@ -0,0 +1,35 @@
+/*  Instrumented copy of the amx_Exec() interpreter loop
+ *
+ *  amx_Exec() only checks the long call timer and the address naught flag
+ *  while it runs. The optional hooks of AMX_EXT_HOOKS (execution history,
+ *  data watchpoints, heap notifications and instruction metering) are
+ *  implemented by amx_ExecInstrumented(), which is compiled from the ANSI C
+ *  version of amx_Exec() in amx.c. amx_Exec() calls it instead of running
+ *  the code itself whenever one of those hooks is set.
+ */
+
+#undef AMX_ALIGN
+#undef AMX_ALLOT
+#undef AMX_CLEANUP
+#undef AMX_CLONE
+#undef AMX_EXEC
+#undef AMX_FLAGS
+#undef AMX_GETADDR
+#undef AMX_INIT
+#undef AMX_MEMINFO
+#undef AMX_NAMELENGTH
+#undef AMX_NATIVEINFO
+#undef AMX_RAISEERROR
+#undef AMX_REGISTER
+#undef AMX_SETCALLBACK
+#undef AMX_SETDEBUGHOOK
+#undef AMX_XXXNATIVES
+#undef AMX_XXXPUBLICS
+#undef AMX_XXXPUBVARS
+#undef AMX_XXXSTRING
+#undef AMX_XXXTAGS
+#undef AMX_XXXUSERDATA
+#undef AMX_UTF8XXX
+
+#define AMX_EXEC_INSTRUMENTED
+#include "amx.c"
@@ -0,0 +1,242 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include "amxcallgraph.h"
+#include "amxcodereader.h"
+
+namespace {
+
+// Names and paths may contain quotes and backslashes (and nothing else
+// that needs escaping in practice).
+std::string Quote(const std::string &s) {
+  std::string result = "\"";
+  for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+    if (*it == '"' || *it == '\\') {
+      result += '\\';
+    }
+    result += *it;
+  }
+  return result + "\"";
+}
+
+std::string GetNativeName(AMXRef amx, int index) {
+  if (const char *name = amx.GetNativeName(index)) {
+    return name;
+  }
+  return "<unknown>";
+}
+
+typedef std::map<std::pair<cell, cell>, int> EdgeMap;
+typedef std::map<std::pair<cell, int>, int> NativeEdgeMap;
+
+} // anonymous namespace
+
+AMXCallGraph::AMXCallGraph(AMXRef amx)
+  : amx_(amx),
+    is_complete_(true)
+{
+  AMXCodeReader reader(amx);
+  AMXInstruction instruction;
+  cell caller = -1;
+
+  while (reader.address() < reader.code_size()) {
+    if (!reader.Read(instruction)) {
+      is_complete_ = false;
+      break;
+    }
+    switch (instruction.opcode) {
+      case AMX_OP_PROC:
+        caller = instruction.address;
+        functions_.push_back(caller);
+        break;
+      case AMX_OP_CALL: {
+        Call call = {
+          instruction.address,
+          caller,
+          reader.GetTarget(instruction.GetParam())
+        };
+        calls_.push_back(call);
+        break;
+      }
+      case AMX_OP_SYSREQ_C: {
+        NativeCall call = {
+          instruction.address,
+          caller,
+          static_cast<int>(instruction.GetParam())
+        };
+        native_calls_.push_back(call);
+        break;
+      }
+      case AMX_OP_SYSREQ_D: {
+        // The parameter is the address of the native function.
+        NativeCall call = {instruction.address, caller, -1};
+        for (int i = 0; i < amx.GetNumNatives(); i++) {
+          if (amx.GetNativeAddress(i) == instruction.GetParam()) {
+            call.index = i;
+            break;
+          }
+        }
+        native_calls_.push_back(call);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  const AMX_HEADER *hdr = amx.GetHeader();
+  if (hdr->cip >= 0) {
+    Public main = {AMX_EXEC_MAIN, hdr->cip};
+    publics_.push_back(main);
+  }
+  for (int i = 0; i < amx.GetNumPublics(); i++) {
+    Public pub = {i, amx.GetPublicAddress(i)};
+    publics_.push_back(pub);
+  }
+}
+
+cell AMXCallGraph::FindFunction(cell address) const {
+  std::vector<cell>::const_iterator iterator =
+    std::upper_bound(functions_.begin(), functions_.end(), address);
+  if (iterator == functions_.begin()) {
+    return -1;
+  }
+  return *(iterator - 1);
+}
+
+void AMXCallGraph::WriteDot(std::ostream &stream,
+                            const std::string &name,
+                            const NameResolver &resolver) const {
+  stream << "digraph " << Quote(name) << " {\n";
+
+  for (std::vector<Public>::const_iterator it = publics_.begin();
+       it != publics_.end(); ++it) {
+    stream << "  " << Quote(resolver(it->address))
+           << " [peripheries=2];\n";
+  }
+
+  EdgeMap edges;
+  for (std::vector<Call>::const_iterator it = calls_.begin();
+       it != calls_.end(); ++it) {
+    edges[std::make_pair(it->caller, it->callee)]++;
+  }
+  for (EdgeMap::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+    stream << "  " << Quote(resolver(it->first.first)) << " -> "
+           << Quote(resolver(it->first.second))
+           << " [label=" << it->second << "];\n";
+  }
+
+  NativeEdgeMap native_edges;
+  for (std::vector<NativeCall>::const_iterator it = native_calls_.begin();
+       it != native_calls_.end(); ++it) {
+    native_edges[std::make_pair(it->caller, it->index)]++;
+  }
+  for (NativeEdgeMap::const_iterator it = native_edges.begin();
+       it != native_edges.end(); ++it) {
+    stream << "  " << Quote(resolver(it->first.first)) << " -> "
+           << Quote("native " + GetNativeName(amx_, it->first.second))
+           << " [label=" << it->second << ", style=dashed];\n";
+  }
+
+  stream << "}\n";
+}
+
+void AMXCallGraph::WriteJson(std::ostream &stream,
+                             const std::string &name,
+                             const NameResolver &resolver) const {
+  stream << "{\n  \"script\": " << Quote(name)
+         << ",\n  \"complete\": " << (is_complete_ ? "true" : "false");
+
+  stream << ",\n  \"functions\": [";
+  for (std::size_t i = 0; i < functions_.size(); i++) {
+    stream << (i > 0 ? "," : "") << "\n    {\"address\": " << functions_[i]
+           << ", \"name\": " << Quote(resolver(functions_[i])) << "}";
+  }
+
+  stream << "\n  ],\n  \"publics\": [";
+  for (std::size_t i = 0; i < publics_.size(); i++) {
+    const char *public_name = amx_.GetPublicName(publics_[i].index);
+    stream << (i > 0 ? "," : "") << "\n    {\"address\": "
+           << publics_[i].address << ", \"name\": "
+           << Quote(public_name != nullptr ? public_name : "") << "}";
+  }
+
+  stream << "\n  ],\n  \"calls\": [";
+  EdgeMap edges;
+  for (std::vector<Call>::const_iterator it = calls_.begin();
+       it != calls_.end(); ++it) {
+    edges[std::make_pair(it->caller, it->callee)]++;
+  }
+  for (EdgeMap::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+    stream << (it != edges.begin() ? "," : "")
+           << "\n    {\"caller\": " << it->first.first
+           << ", \"callee\": " << it->first.second
+           << ", \"sites\": " << it->second << "}";
+  }
+
+  stream << "\n  ],\n  \"native_calls\": [";
+  NativeEdgeMap native_edges;
+  for (std::vector<NativeCall>::const_iterator it = native_calls_.begin();
+       it != native_calls_.end(); ++it) {
+    native_edges[std::make_pair(it->caller, it->index)]++;
+  }
+  for (NativeEdgeMap::const_iterator it = native_edges.begin();
+       it != native_edges.end(); ++it) {
+    stream << (it != native_edges.begin() ? "," : "")
+           << "\n    {\"caller\": " << it->first.first
+           << ", \"native\": " << Quote(GetNativeName(amx_, it->first.second))
+           << ", \"sites\": " << it->second << "}";
+  }
+
+  stream << "\n  ]\n}\n";
+}
+
+AMXCallGraphs::AMXCallGraphs(AMX *amx)
+  : AMXHandler<AMXCallGraphs>(amx) {
+}
+
+// static
+std::shared_ptr<const AMXCallGraph> AMXCallGraphs::GetGraph(AMXRef amx) {
+  AMXCallGraphs *graphs = GetHandler(amx.amx());
+  if (graphs != nullptr) {
+    return graphs->GetCachedGraph();
+  }
+  return std::make_shared<AMXCallGraph>(amx);
+}
+
+std::shared_ptr<const AMXCallGraph> AMXCallGraphs::GetCachedGraph() {
+  // Same as AMXStateTables::GetCachedTable(): never wait for the lock as
+  // the caller may be a signal handler that interrupted its owner.
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return std::make_shared<AMXCallGraph>(amx());
+  }
+  if (!graph_) {
+    graph_ = std::make_shared<AMXCallGraph>(amx());
+  }
+  return graph_;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXCALLGRAPH_H
+#define AMXCALLGRAPH_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+#include "amxhandler.h"
+#include "amxref.h"
+
+// Static call graph of an AMX decoded from its code section: the functions
+// (everything that starts with PROC), direct calls between them, native
+// call sites and public entry points. Call sites are attributed to the
+// nearest preceding function.
+class AMXCallGraph {
+ public:
+  struct Call {
+    cell address;  // address of the CALL instruction
+    cell caller;   // address of the calling function
+    cell callee;   // address of the called function
+  };
+
+  struct NativeCall {
+    cell address;  // address of the SYSREQ instruction
+    cell caller;
+    int index;     // index of the native or -1 if unknown
+  };
+
+  struct Public {
+    int index;     // AMX_EXEC_MAIN for main()
+    cell address;
+  };
+
+  typedef std::function<std::string (cell address)> NameResolver;
+
+  explicit AMXCallGraph(AMXRef amx);
+
+  // Returns false if decoding stopped at an invalid instruction; everything
+  // decoded before it is still available.
+  bool IsComplete() const { return is_complete_; }
+
+  const std::vector<cell> &functions() const { return functions_; }
+  const std::vector<Call> &calls() const { return calls_; }
+  const std::vector<NativeCall> &native_calls() const {
+    return native_calls_;
+  }
+  const std::vector<Public> &publics() const { return publics_; }
+
+  // Returns the address of the function that contains the specified code
+  // address or -1 if it's before the first function.
+  cell FindFunction(cell address) const;
+
+  // Export the graph in Graphviz DOT or JSON format. Function names are
+  // obtained from the resolver. Edges are merged per caller/callee pair
+  // and annotated with the number of call sites.
+  void WriteDot(std::ostream &stream,
+                const std::string &name,
+                const NameResolver &resolver) const;
+  void WriteJson(std::ostream &stream,
+                 const std::string &name,
+                 const NameResolver &resolver) const;
+
+ private:
+  AMXRef amx_;
+  bool is_complete_;
+  std::vector<cell> functions_;
+  std::vector<Call> calls_;
+  std::vector<NativeCall> native_calls_;
+  std::vector<Public> publics_;
+};
+
+// Caches the call graph of an AMX instance. The graph is decoded on first
+// use and never changes afterwards. If the cache is busy, e.g. when called
+// from a signal handler, the graph is decoded without caching it.
+class AMXCallGraphs: public AMXHandler<AMXCallGraphs> {
+  friend class AMXHandler<AMXCallGraphs>;
+
+ public:
+  // Returns the call graph of the AMX. The graph is cached if the AMX has
+  // a handler and is decoded every time otherwise.
+  static std::shared_ptr<const AMXCallGraph> GetGraph(AMXRef amx);
+
+ private:
+  explicit AMXCallGraphs(AMX *amx);
+
+  std::shared_ptr<const AMXCallGraph> GetCachedGraph();
+
+ private:
+  std::mutex mutex_;
+  std::shared_ptr<const AMXCallGraph> graph_;
+};
+
+#endif // !AMXCALLGRAPH_H
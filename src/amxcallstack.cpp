@@ -22,9 +22,17 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
 #include "amxcallstack.h"
 
+namespace {
+
+const std::size_t kMinCapacity = 64;
+
+} // anonymous namespace
+
 AMXCall::AMXCall(Type type, AMXRef amx, cell index)
  : amx_(amx),
    type_(type),
@@ -53,27 +61,72 @@ AMXCall AMXCall::Native(AMXRef amx, cell index) {
   return AMXCall(NATIVE, amx, index);
 }
 
+AMXCallStack::AMXCallStack()
+  : data_(nullptr),
+    size_(0)
+{
+}
+
+AMXCallStack::AMXCallStack(const AMXCallStack &other)
+  : calls_(other.calls_),
+    data_(nullptr),
+    size_(0)
+{
+  Publish();
+}
+
+AMXCallStack &AMXCallStack::operator=(const AMXCallStack &other) {
+  calls_ = other.calls_;
+  Publish();
+  return *this;
+}
+
 bool AMXCallStack::IsEmpty() const {
-  return call_stack_.empty();
+  return calls_.empty();
 }
 
 AMXCall &AMXCallStack::Top() {
   assert(!IsEmpty());
-  return call_stack_.top();
+  return calls_.back();
 }
 
 const AMXCall &AMXCallStack::Top() const {
   assert(!IsEmpty());
-  return call_stack_.top();
+  return calls_.back();
 }
 
 void AMXCallStack::Push(AMXCall call) {
-  call_stack_.push(call);
+  if (calls_.size() == calls_.capacity()) {
+    // Grow the stack by hand so that the old buffer can be kept around.
+    std::vector<AMXCall> calls;
+    calls.reserve(std::max(calls_.capacity() * 2, kMinCapacity));
+    calls.assign(calls_.begin(), calls_.end());
+    calls_.swap(calls);
+    old_calls_.push_back(std::move(calls));
+    data_.store(calls_.data(), std::memory_order_release);
+  }
+  calls_.push_back(call);
+  size_.store(calls_.size(), std::memory_order_release);
 }
 
 AMXCall AMXCallStack::Pop() {
   assert(!IsEmpty());
-  AMXCall result = call_stack_.top();
-  call_stack_.pop();
+  AMXCall result = calls_.back();
+  calls_.pop_back();
+  size_.store(calls_.size(), std::memory_order_release);
   return result;
 }
+
+void AMXCallStack::CopyFrom(const AMXCallStack &other) {
+  // The buffer is replaced before the size grows past its old capacity, so
+  // reading the size first guarantees that the buffer is big enough.
+  std::size_t size = other.size_.load(std::memory_order_acquire);
+  const AMXCall *data = other.data_.load(std::memory_order_acquire);
+  calls_.assign(data, data + size);
+  Publish();
+}
+
+void AMXCallStack::Publish() {
+  data_.store(calls_.data(), std::memory_order_release);
+  size_.store(calls_.size(), std::memory_order_release);
+}
@@ -25,7 +25,9 @@
 #ifndef AMXCALLSTACK_H
 #define AMXCALLSTACK_H
 
-#include <stack>
+#include <atomic>
+#include <cstddef>
+#include <vector>
 #include "amxref.h"
 
 class AMXCall {
@@ -59,8 +61,14 @@ class AMXCall {
   cell index_;
 };
 
+// Only the owning thread may push and pop calls, but other threads may copy
+// the stack at the same time with CopyFrom().
 class AMXCallStack {
  public:
+  AMXCallStack();
+  AMXCallStack(const AMXCallStack &other);
+  AMXCallStack &operator=(const AMXCallStack &other);
+
   bool IsEmpty() const;
 
   AMXCall &Top();
@@ -69,8 +77,21 @@ class AMXCallStack {
   void Push(AMXCall call);
   AMXCall Pop();
 
+  // Copies a stack that its owner may be changing. This never reads freed
+  // memory, but the copy may be torn: the caller has to find out whether
+  // the owner has changed the stack in the meantime.
+  void CopyFrom(const AMXCallStack &other);
+
+ private:
+  void Publish();
+
  private:
-  std::stack<AMXCall> call_stack_;
+  std::vector<AMXCall> calls_;
+  // Buffers that calls_ has outgrown. Other threads may still be copying
+  // from them, so they live as long as the stack.
+  std::vector<std::vector<AMXCall>> old_calls_;
+  std::atomic<const AMXCall*> data_;
+  std::atomic<std::size_t> size_;
 };
 
 #endif // !AMXCALLSTACK_H
@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "amxcodereader.h"
+
+AMXCodeReader::AMXCodeReader(AMXRef amx, cell address)
+  : code_(amx.GetCode()),
+    code_size_(amx.GetHeader()->dat - amx.GetHeader()->cod),
+    address_(address)
+{
+}
+
+bool AMXCodeReader::Read(AMXInstruction &instruction) {
+  if (address_ < 0 ||
+      address_ + static_cast<cell>(sizeof(cell)) > code_size_) {
+    return false;
+  }
+
+  const cell *ip = reinterpret_cast<const cell*>(code_ + address_);
+  AMXOpcode opcode = UnrelocateAMXOpcode(ip[0]);
+  if (opcode == AMX_OP_NONE) {
+    return false;
+  }
+
+  cell size;
+  int num_params = GetAMXOpcodeNumParams(opcode);
+  if (num_params >= 0) {
+    size = (1 + num_params) * sizeof(cell);
+  } else {
+    if (address_ + static_cast<cell>(2 * sizeof(cell)) > code_size_) {
+      return false;
+    }
+    if (opcode == AMX_OP_CASETBL) {
+      // The number of records, the default address and the records.
+      num_params = 2 * ip[1] + 2;
+      size = (1 + num_params) * sizeof(cell);
+    } else {
+      // FILE and SYMBOL: the size of the data in bytes and the data itself.
+      num_params = 1;
+      size = 2 * sizeof(cell) + ip[1];
+    }
+  }
+  if (size <= 0 || address_ + size > code_size_) {
+    return false;
+  }
+
+  instruction.address = address_;
+  instruction.size = size;
+  instruction.opcode = opcode;
+  instruction.params = ip + 1;
+  instruction.num_params = num_params;
+
+  address_ += size;
+  return true;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXCODEREADER_H
+#define AMXCODEREADER_H
+
+#include <amx/amx.h>
+#include "amxopcode.h"
+#include "amxref.h"
+
+struct AMXInstruction {
+  cell address;
+  cell size;
+  AMXOpcode opcode;
+  const cell *params;
+  int num_params;
+
+  cell GetParam(int index = 0) const { return params[index]; }
+};
+
+// Decodes the relocated code section of a loaded AMX one instruction at a
+// time. Jump and call targets are stored as absolute pointers after
+// relocation, GetTarget() converts them back to code addresses.
+class AMXCodeReader {
+ public:
+  explicit AMXCodeReader(AMXRef amx, cell address = 0);
+
+  cell address() const { return address_; }
+  void set_address(cell address) { address_ = address; }
+
+  cell code_size() const { return code_size_; }
+
+  // Decodes the instruction at the current address and advances past it.
+  // Returns false at the end of the code or if the instruction is invalid.
+  bool Read(AMXInstruction &instruction);
+
+  // Converts a relocated jump, call or case table address to a code address.
+  cell GetTarget(cell param) const {
+    return param - reinterpret_cast<cell>(code_);
+  }
+
+ private:
+  const unsigned char *code_;
+  cell code_size_;
+  cell address_;
+};
+
+#endif // !AMXCODEREADER_H
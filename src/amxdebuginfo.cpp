@@ -22,10 +22,27 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include "amxdebuginfo.h"
+#include "fileutils.h"
+
+namespace {
+
+// Detached debug info files start with the header of the original AMX
+// with its size adjusted to point past this record, so dbg_LoadInfo()
+// finds the debug info right after it.
+struct DetachedRecord {
+  char magic[4];
+  uint32_t reserved;
+  uint64_t code_hash;
+};
+
+const char kDetachedMagic[] = {'C', 'D', 'B', 'G'};
+
+} // anonymous namespace
 
 std::vector<AMXDebugInfo::SymbolDim> AMXDebugInfo::Symbol::GetDims() const {
   std::vector<AMXDebugSymbolDim> dims;
@@ -39,6 +56,12 @@ std::vector<AMXDebugInfo::SymbolDim> AMXDebugInfo::Symbol::GetDims() const {
   return dims;
 }
 
+AMXDebugInfo::SymbolDim AMXDebugInfo::Symbol::GetDim(int index) const {
+  assert(index >= 0 && index < GetNumDims());
+  const char *dimPtr = symbol_->name + std::strlen(symbol_->name) + 1;
+  return SymbolDim(reinterpret_cast<const AMX_DBG_SYMDIM*>(dimPtr) + index);
+}
+
 AMXDebugInfo::AMXDebugInfo()
   : amxdbg_(nullptr)
 {
@@ -61,21 +84,61 @@ bool AMXDebugInfo::IsLoaded() const {
 void AMXDebugInfo::Load(const std::string &filename) {
   std::FILE* fp = std::fopen(filename.c_str(), "rb");
   if (fp != nullptr) {
-    AMX_DBG amxdbg;
-    if (dbg_LoadInfo(&amxdbg, fp) == AMX_ERR_NONE) {
-      amxdbg_ = new AMX_DBG(amxdbg);
-    }
+    Load(fp);
     fclose(fp);
   }
+  if (!IsLoaded()) {
+    LoadDetached(filename);
+  }
+}
+
+void AMXDebugInfo::LoadDetached(const std::string &filename) {
+  // Called from the prefetcher's threads, so the hooked fopen() must not be
+  // used here.
+  uint64_t code_hash;
+  std::FILE *fp = fileutils::OpenFileForReading(filename);
+  if (fp == nullptr) {
+    return;
+  }
+  bool have_hash = GetCodeHash(fp, code_hash);
+  fclose(fp);
+  if (!have_hash) {
+    return;
+  }
+
+  fp = fileutils::OpenFileForReading(filename + ".dbg");
+  if (fp == nullptr) {
+    return;
+  }
+  DetachedRecord record;
+  if (std::fseek(fp, sizeof(AMX_HEADER), SEEK_SET) == 0
+      && std::fread(&record, sizeof(record), 1, fp) == 1
+      && std::memcmp(record.magic, kDetachedMagic, sizeof(record.magic)) == 0
+      && record.code_hash == code_hash) {
+    Load(fp);
+  }
+  fclose(fp);
+}
+
+void AMXDebugInfo::Load(std::FILE *fp) {
+  AMX_DBG amxdbg;
+  if (dbg_LoadInfo(&amxdbg, fp) == AMX_ERR_NONE) {
+    amxdbg_ = new AMX_DBG(amxdbg);
+  }
 }
 
 void AMXDebugInfo::Free() {
   if (amxdbg_ != nullptr) {
     dbg_FreeInfo(amxdbg_);
     delete amxdbg_;
+    amxdbg_ = nullptr;
   }
 }
 
+void AMXDebugInfo::Swap(AMXDebugInfo &other) {
+  std::swap(amxdbg_, other.amxdbg_);
+}
+
 AMXDebugLine AMXDebugInfo::GetLine(cell address) const {
   Line line;
   LineTable lines = GetLines();
@@ -147,6 +210,25 @@ AMXDebugSymbol AMXDebugInfo::GetExactFunction(
   return function;
 }
 
+AMXDebugSymbol AMXDebugInfo::GetStaticVariable(
+  const std::string &name) const
+{
+  Symbol variable;
+  SymbolTable symbols = GetSymbols();
+  for (SymbolTable::const_iterator it = symbols.begin();
+       it != symbols.end(); ++it) {
+    if (it->IsLocal())
+      continue;
+    if (!it->IsVariable() && !it->IsArray())
+      continue;
+    if (it->GetName() == name) {
+      variable = *it;
+      break;
+    }
+  }
+  return variable;
+}
+
 AMXDebugTag AMXDebugInfo::GetTag(int32_t tag_id) const {
   Tag tag;
   TagTable tags = GetTags();
@@ -236,6 +318,36 @@ cell AMXDebugInfo::GetLineAddress(long line, const std::string &file) const {
   return static_cast<cell>(address);
 }
 
+// static
+bool AMXDebugInfo::GetCodeHash(std::FILE *fp, uint64_t &hash) {
+  AMX_HEADER hdr;
+  if (std::fseek(fp, 0, SEEK_SET) != 0
+      || std::fread(&hdr, sizeof(hdr), 1, fp) != 1
+      || hdr.magic != AMX_MAGIC
+      || hdr.cod < static_cast<cell>(sizeof(hdr))
+      || hdr.dat < hdr.cod
+      || std::fseek(fp, hdr.cod, SEEK_SET) != 0) {
+    return false;
+  }
+
+  // Compact files store less than dat - cod bytes of code.
+  long size = std::min(hdr.dat, hdr.size) - hdr.cod;
+  hash = 14695981039346656037ULL;
+  unsigned char buffer[4096];
+  while (size > 0) {
+    std::size_t count = std::fread(buffer, 1,
+      std::min<std::size_t>(sizeof(buffer), size), fp);
+    if (count == 0) {
+      return false;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      hash = (hash ^ buffer[i]) * 1099511628211ULL;
+    }
+    size -= static_cast<long>(count);
+  }
+  return true;
+}
+
 // static
 bool AMXDebugInfo::IsPresent(AMX *amx) {
   uint16_t flags;
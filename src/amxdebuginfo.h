@@ -26,6 +26,7 @@
 #define AMXDEBUGINFO_H
 
 #include <cassert>
+#include <cstdio>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -110,6 +111,8 @@ class AMXDebugInfo {
 
     std::string GetName() const
       { return file_->name; }
+    const char *GetNamePtr() const
+      { return file_->name; }
     cell GetAddress() const
       { return file_->address; }
     operator bool() const
@@ -144,6 +147,8 @@ class AMXDebugInfo {
       { return tag_->tag; }
     std::string GetName() const
       { return tag_->name; }    
+    const char *GetNamePtr() const
+      { return tag_->name; }
     operator bool() const
       { return tag_ != nullptr; }
 
@@ -162,6 +167,8 @@ class AMXDebugInfo {
       { return automaton_->address; }
     std::string GetName() const
       { return automaton_->name; }
+    const char *GetNamePtr() const
+      { return automaton_->name; }
     operator bool() const
       { return automaton_ != nullptr; }
 
@@ -180,6 +187,8 @@ class AMXDebugInfo {
       { return state_->automaton; }
     std::string GetName() const
       { return state_->name; }
+    const char *GetNamePtr() const
+      { return state_->name; }
     operator bool() const
       { return state_ != nullptr; }
 
@@ -247,10 +256,13 @@ class AMXDebugInfo {
       { return symbol_->dim; }
     std::string GetName() const
       { return symbol_->name; }
+    const char *GetNamePtr() const
+      { return symbol_->name; }
     int16_t GetNumDims() const
       { return symbol_->dim; }
 
     std::vector<SymbolDim> GetDims() const;
+    SymbolDim GetDim(int index) const;
 
     operator bool() const { return symbol_ != nullptr; }
 
@@ -278,14 +290,26 @@ class AMXDebugInfo {
   explicit AMXDebugInfo(const std::string &filename);
   ~AMXDebugInfo();
 
+  // Loads debug info embedded in the AMX file and if there is none, from
+  // the detached file <filename>.dbg.
   void Load(const std::string &filename);
+  void Load(std::FILE *fp);
+
+  // Loads debug info from <filename>.dbg, which is created by
+  // tools/splitdbg.py. The file records a hash of the code section of the
+  // AMX it was split from and is ignored unless it matches filename.
+  void LoadDetached(const std::string &filename);
   bool IsLoaded() const;
   void Free();
 
+  // Exchanges the loaded debug info with another object.
+  void Swap(AMXDebugInfo &other);
+
   Line GetLine(cell address) const;
   File GetFile(cell address) const;
   Symbol GetFunction(cell address, bool ignoreBrokenSymbols = true) const;
   Symbol GetExactFunction(cell address, bool ignoreBrokenSymbols = true) const;
+  Symbol GetStaticVariable(const std::string &name) const;
   Tag GetTag(int32_t tag_id) const;  
   Automaton GetAutomaton(cell address) const;
   State GetState(int16_t automaton_id, int16_t state_id) const;
@@ -331,6 +355,9 @@ class AMXDebugInfo {
 
   static bool IsPresent(AMX *amx);
 
+  // Computes the FNV-1a hash of the code section of an AMX file.
+  static bool GetCodeHash(std::FILE *fp, uint64_t &hash);
+
  private:
   AMXDebugInfo(const AMXDebugInfo &);
   AMXDebugInfo &operator=(const AMXDebugInfo &);
@@ -0,0 +1,154 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstdio>
+#include "amxdebuginfoprefetcher.h"
+#include "fileutils.h"
+
+namespace {
+
+// Loading debug info is mostly disk bound, more threads than this don't make
+// it any faster.
+const std::size_t kMaxThreads = 4;
+
+} // anonymous namespace
+
+AMXDebugInfoPrefetcher::AMXDebugInfoPrefetcher()
+  : next_entry_(0),
+    stopping_(false)
+{
+}
+
+AMXDebugInfoPrefetcher::~AMXDebugInfoPrefetcher() {
+  Stop();
+}
+
+void AMXDebugInfoPrefetcher::Start(
+    const std::list<std::string> &search_paths) {
+  for (std::list<std::string>::const_iterator dir_it = search_paths.begin();
+       dir_it != search_paths.end(); dir_it++) {
+    std::vector<std::string> files;
+    fileutils::GetDirectoryFiles(*dir_it, "*.amx", files);
+
+    // Same naming as in AMXPathFinder, so that Claim() can find the files.
+    for (std::vector<std::string>::const_iterator file_it = files.begin();
+         file_it != files.end(); file_it++) {
+      std::unique_ptr<Entry> entry(new Entry);
+      entry->path = *dir_it + fileutils::kNativePathSepString + *file_it;
+      entry->mtime = fileutils::GetModificationTime(entry->path);
+      entry->loaded = false;
+      entries_.push_back(std::move(entry));
+    }
+  }
+
+  next_entry_ = 0;
+  stopping_ = false;
+
+  std::size_t num_threads =
+    std::min<std::size_t>(std::thread::hardware_concurrency(), kMaxThreads);
+  num_threads = std::min(std::max<std::size_t>(num_threads, 1),
+                         entries_.size());
+  for (std::size_t i = 0; i < num_threads; i++) {
+    threads_.push_back(std::thread(&AMXDebugInfoPrefetcher::Run, this));
+  }
+}
+
+void AMXDebugInfoPrefetcher::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  for (std::vector<std::thread>::iterator it = threads_.begin();
+       it != threads_.end(); it++) {
+    it->join();
+  }
+  threads_.clear();
+  entries_.clear();
+}
+
+void AMXDebugInfoPrefetcher::Discard() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stopping_ = true;
+  for (std::vector<std::unique_ptr<Entry>>::iterator it = entries_.begin();
+       it != entries_.end(); it++) {
+    (*it)->debug_info.Free();
+  }
+  loaded_.notify_all();
+}
+
+void AMXDebugInfoPrefetcher::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_ && next_entry_ < entries_.size()) {
+    Entry *entry = entries_[next_entry_++].get();
+
+    lock.unlock();
+    AMXDebugInfo debug_info;
+    if (std::FILE *fp = fileutils::OpenFileForReading(entry->path)) {
+      debug_info.Load(fp);
+      std::fclose(fp);
+    }
+    if (!debug_info.IsLoaded()) {
+      debug_info.LoadDetached(entry->path);
+    }
+    lock.lock();
+
+    if (stopping_) {
+      break;
+    }
+    entry->debug_info.Swap(debug_info);
+    entry->loaded = true;
+    loaded_.notify_all();
+  }
+}
+
+bool AMXDebugInfoPrefetcher::Claim(const std::string &path,
+                                   AMXDebugInfo &debug_info) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (std::vector<std::unique_ptr<Entry>>::iterator it = entries_.begin();
+       it != entries_.end(); it++) {
+    Entry *entry = it->get();
+    if (entry->path != path) {
+      continue;
+    }
+    while (!entry->loaded && !stopping_) {
+      loaded_.wait(lock);
+    }
+    bool claimed = entry->loaded
+      && entry->debug_info.IsLoaded()
+      && entry->mtime == fileutils::GetModificationTime(path);
+    if (claimed) {
+      debug_info.Swap(entry->debug_info);
+    }
+    entry->debug_info.Free();
+    return claimed;
+  }
+  return false;
+}
+
+// static
+AMXDebugInfoPrefetcher &AMXDebugInfoPrefetcher::shared() {
+  static AMXDebugInfoPrefetcher instance;
+  return instance;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXDEBUGINFOPREFETCHER_H
+#define AMXDEBUGINFOPREFETCHER_H
+
+#include <condition_variable>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "amxdebuginfo.h"
+
+// Loads the debug info of all scripts found in the search paths on a few
+// background threads when the plugin starts, so that scripts loaded later
+// don't have to parse it on the main thread.
+class AMXDebugInfoPrefetcher {
+ public:
+  AMXDebugInfoPrefetcher();
+  ~AMXDebugInfoPrefetcher();
+
+  void Start(const std::list<std::string> &search_paths);
+  void Stop();
+
+  // Frees the debug info that nobody has claimed and stops loading the rest.
+  // Called once the server has loaded its scripts. Doesn't wait for the
+  // threads to finish the files they are currently loading.
+  void Discard();
+
+  // Moves the prefetched debug info of the script at the specified path
+  // into debug_info, waiting for it to be loaded if necessary. Returns false
+  // if the file was not prefetched, has no debug info, has changed since
+  // then or was already claimed.
+  bool Claim(const std::string &path, AMXDebugInfo &debug_info);
+
+  static AMXDebugInfoPrefetcher &shared();
+
+ private:
+  struct Entry {
+    std::string path;
+    std::time_t mtime;
+    AMXDebugInfo debug_info;
+    bool loaded;
+  };
+
+  void Run();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable loaded_;
+  std::vector<std::unique_ptr<Entry>> entries_;
+  std::size_t next_entry_;
+  bool stopping_;
+  std::vector<std::thread> threads_;
+};
+
+#endif // !AMXDEBUGINFOPREFETCHER_H
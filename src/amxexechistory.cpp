@@ -0,0 +1,52 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include "amxexechistory.h"
+
+AMXExecHistory::AMXExecHistory(unsigned int size) {
+  unsigned int capacity = 1;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  entries_.resize(2 * capacity);
+  ring_.entries = &entries_[0];
+  ring_.mask = capacity - 1;
+  ring_.next = 0;
+}
+
+unsigned int AMXExecHistory::GetNumEntries() const {
+  return ring_.next < GetCapacity() ? ring_.next : GetCapacity();
+}
+
+AMXExecHistory::Entry AMXExecHistory::GetEntry(unsigned int index) const {
+  assert(index < GetNumEntries());
+  unsigned int position = (ring_.next - GetNumEntries() + index) & ring_.mask;
+  Entry entry = {entries_[2 * position], entries_[2 * position + 1]};
+  return entry;
+}
+
+void AMXExecHistory::Clear() {
+  ring_.next = 0;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXEXECHISTORY_H
+#define AMXEXECHISTORY_H
+
+#include <vector>
+#include <amx/amx.h>
+
+// A ring buffer of the most recent control transfers (taken branches, calls
+// and returns) made by an AMX instance. The interpreter writes to the ring
+// directly through AMX_EXT_HOOKS::exec_history.
+class AMXExecHistory {
+ public:
+  struct Entry {
+    cell from;
+    cell to;
+  };
+
+  explicit AMXExecHistory(unsigned int size);
+
+  AMX_EXEC_HISTORY *ring() { return &ring_; }
+
+  unsigned int GetCapacity() const { return ring_.mask + 1; }
+  unsigned int GetNumEntries() const;
+
+  // Index 0 refers to the oldest entry that is still in the ring.
+  Entry GetEntry(unsigned int index) const;
+
+  void Clear();
+
+ private:
+  AMXExecHistory(const AMXExecHistory &);
+  AMXExecHistory &operator=(const AMXExecHistory &);
+
+ private:
+  std::vector<cell> entries_;
+  AMX_EXEC_HISTORY ring_;
+};
+
+#endif // !AMXEXECHISTORY_H
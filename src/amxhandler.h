@@ -40,6 +40,9 @@ class AMXHandler {
   static T *GetHandler(AMX *amx);
   static void DestroyHandler(AMX *amx);
 
+  template<typename Func>
+  static void ForEachHandler(Func func);
+
  private:
   AMX *amx_;
 
@@ -80,4 +83,14 @@ void AMXHandler<T>::DestroyHandler(AMX *amx) {
   }
 }
 
+// static
+template<typename T>
+template<typename Func>
+void AMXHandler<T>::ForEachHandler(Func func) {
+  for (typename HandlerMap::const_iterator iterator = handlers_.begin();
+       iterator != handlers_.end(); iterator++) {
+    func(iterator->second);
+  }
+}
+
 #endif // !AMXHANDLER_H
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "amxheapprofiler.h"
+
+AMXHeapProfiler::Site::Site()
+  : address(0),
+    count(0),
+    bytes(0),
+    live_bytes(0),
+    peak_bytes(0),
+    num_freed(0),
+    total_lifetime(0)
+{
+}
+
+std::chrono::nanoseconds AMXHeapProfiler::Site::GetAverageLifetime() const {
+  if (num_freed == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return total_lifetime / num_freed;
+}
+
+void AMXHeapProfiler::OnHeapChange(cell site, cell from, cell to) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  // Anything above the new top is gone. This also drops allocations that
+  // were discarded without telling us (e.g. when amx_Exec() aborts).
+  Free(std::min(from, to), now);
+
+  if (to > from) {
+    Site &s = sites_[site];
+    s.address = site;
+    s.count++;
+    s.bytes += to - from;
+    s.live_bytes += to - from;
+    s.peak_bytes = std::max(s.peak_bytes, s.live_bytes);
+
+    Allocation allocation = {from, to - from, &s, now};
+    allocations_.push_back(allocation);
+  }
+}
+
+void AMXHeapProfiler::Free(cell address,
+                           std::chrono::steady_clock::time_point now) {
+  while (!allocations_.empty() && allocations_.back().address >= address) {
+    const Allocation &allocation = allocations_.back();
+    Site *site = allocation.site;
+    site->live_bytes -= allocation.size;
+    site->num_freed++;
+    site->total_lifetime +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - allocation.time);
+    allocations_.pop_back();
+  }
+}
+
+std::vector<AMXHeapProfiler::Site> AMXHeapProfiler::GetSites() const {
+  std::vector<Site> sites;
+  for (std::map<cell, Site>::const_iterator it = sites_.begin();
+       it != sites_.end(); it++) {
+    sites.push_back(it->second);
+  }
+  std::stable_sort(sites.begin(), sites.end(),
+    [](const Site &a, const Site &b) {
+      return a.bytes > b.bytes;
+    });
+  return sites;
+}
+
+void AMXHeapProfiler::Clear() {
+  allocations_.clear();
+  sites_.clear();
+}
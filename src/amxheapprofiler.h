@@ -0,0 +1,80 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXHEAPPROFILER_H
+#define AMXHEAPPROFILER_H
+
+#include <chrono>
+#include <map>
+#include <vector>
+#include <amx/amx.h>
+
+// Attributes heap allocations of a script to the code that made them. The
+// interpreter reports every move of the heap top through
+// AMX_EXT_HOOKS::heap_ctl; since the AMX heap is a stack, an allocation is
+// freed as soon as the top goes below its start address.
+class AMXHeapProfiler {
+ public:
+  // Allocations made by the host (e.g. arguments of a public function) are
+  // attributed to this site.
+  static const cell kHostSite = -1;
+
+  struct Site {
+    Site();
+
+    cell address;
+    unsigned long count;
+    unsigned long long bytes;
+    cell live_bytes;
+    cell peak_bytes;
+    unsigned long num_freed;
+    std::chrono::nanoseconds total_lifetime;
+
+    std::chrono::nanoseconds GetAverageLifetime() const;
+  };
+
+  void OnHeapChange(cell site, cell from, cell to);
+
+  // Returns the sites sorted by the number of bytes allocated, largest first.
+  std::vector<Site> GetSites() const;
+
+  bool IsEmpty() const { return sites_.empty(); }
+  void Clear();
+
+ private:
+  struct Allocation {
+    cell address;
+    cell size;
+    Site *site;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  void Free(cell address, std::chrono::steady_clock::time_point now);
+
+ private:
+  std::vector<Allocation> allocations_;
+  std::map<cell, Site> sites_;
+};
+
+#endif // !AMXHEAPPROFILER_H
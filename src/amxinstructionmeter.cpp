@@ -0,0 +1,151 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "amxinstructionmeter.h"
+
+namespace {
+
+template<typename Key>
+bool CompareInstructions(
+    const std::pair<Key, AMXInstructionMeter::Counter> &a,
+    const std::pair<Key, AMXInstructionMeter::Counter> &b) {
+  return a.second.instructions > b.second.instructions;
+}
+
+} // anonymous namespace
+
+AMXInstructionMeter::Counter::Counter()
+  : instructions(0),
+    calls(0)
+{
+}
+
+AMXInstructionMeter::AMXInstructionMeter()
+  : meter_(),
+    last_count_(0),
+    total_(0)
+{
+}
+
+void AMXInstructionMeter::Update() {
+  // The counter wraps around, but the difference is still correct as long
+  // as fewer than 2^32 instructions are executed between two updates.
+  ucell delta = meter_.count - last_count_;
+  last_count_ = meter_.count;
+  total_ += delta;
+  if (!functions_stack_.empty()) {
+    functions_[functions_stack_.back()].instructions += delta;
+  }
+}
+
+void AMXInstructionMeter::BeginPublic(int index) {
+  Update();
+  PublicCall call;
+  call.index = index;
+  call.start_total = total_;
+  call.depth = functions_stack_.size();
+  publics_stack_.push_back(call);
+}
+
+void AMXInstructionMeter::EndPublic() {
+  Update();
+  if (publics_stack_.empty()) {
+    return;
+  }
+  const PublicCall &call = publics_stack_.back();
+  Counter &counter = publics_[call.index];
+  counter.instructions += total_ - call.start_total;
+  counter.calls++;
+  // If the public was aborted by an error, the functions that were running
+  // never returned.
+  functions_stack_.resize(std::min(functions_stack_.size(), call.depth));
+  publics_stack_.pop_back();
+}
+
+void AMXInstructionMeter::OnEnter(cell address) {
+  Update();
+  functions_stack_.push_back(address);
+  functions_[address].calls++;
+}
+
+void AMXInstructionMeter::OnLeave() {
+  Update();
+  if (!functions_stack_.empty()) {
+    functions_stack_.pop_back();
+  }
+}
+
+const AMXInstructionMeter::Counter *AMXInstructionMeter::GetPublicCounter(
+    int index) const {
+  std::map<int, Counter>::const_iterator iterator = publics_.find(index);
+  if (iterator != publics_.end()) {
+    return &iterator->second;
+  }
+  return nullptr;
+}
+
+const AMXInstructionMeter::Counter *AMXInstructionMeter::GetFunctionCounter(
+    cell address) const {
+  std::unordered_map<cell, Counter>::const_iterator iterator =
+    functions_.find(address);
+  if (iterator != functions_.end()) {
+    return &iterator->second;
+  }
+  return nullptr;
+}
+
+std::vector<std::pair<int, AMXInstructionMeter::Counter>>
+    AMXInstructionMeter::GetPublics() const {
+  std::vector<std::pair<int, Counter>> publics(publics_.begin(),
+                                               publics_.end());
+  std::stable_sort(publics.begin(), publics.end(), CompareInstructions<int>);
+  return publics;
+}
+
+std::vector<std::pair<cell, AMXInstructionMeter::Counter>>
+    AMXInstructionMeter::GetFunctions() const {
+  std::vector<std::pair<cell, Counter>> functions(functions_.begin(),
+                                                  functions_.end());
+  // Sort by address first so that the order doesn't depend on hashing.
+  std::sort(functions.begin(), functions.end(),
+            [](const std::pair<cell, Counter> &a,
+               const std::pair<cell, Counter> &b) {
+              return a.first < b.first;
+            });
+  std::stable_sort(functions.begin(), functions.end(),
+                   CompareInstructions<cell>);
+  return functions;
+}
+
+void AMXInstructionMeter::Clear() {
+  Update();
+  total_ = 0;
+  publics_.clear();
+  functions_.clear();
+  // Calls in progress are counted from now on.
+  for (std::size_t i = 0; i < publics_stack_.size(); i++) {
+    publics_stack_[i].start_total = 0;
+  }
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXINSTRUCTIONMETER_H
+#define AMXINSTRUCTIONMETER_H
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <amx/amx.h>
+
+// Counts the instructions executed by a script and attributes them to public
+// functions (including everything they call) and to individual functions
+// (excluding their callees). Unlike time, instruction counts don't depend on
+// the machine or its load, so they can be compared between runs.
+class AMXInstructionMeter {
+ public:
+  struct Counter {
+    Counter();
+
+    unsigned long long instructions;
+    unsigned long calls;
+  };
+
+  AMXInstructionMeter();
+
+  AMX_METER *meter() { return &meter_; }
+
+  void BeginPublic(int index);
+  void EndPublic();
+
+  // Called by the interpreter through AMX_METER::callback.
+  void OnEnter(cell address);
+  void OnLeave();
+
+  unsigned long long total() const { return total_; }
+
+  // Returns nullptr if the public or function hasn't been called.
+  const Counter *GetPublicCounter(int index) const;
+  const Counter *GetFunctionCounter(cell address) const;
+
+  // Return the counters sorted by the number of instructions, largest first.
+  std::vector<std::pair<int, Counter>> GetPublics() const;
+  std::vector<std::pair<cell, Counter>> GetFunctions() const;
+
+  void Clear();
+
+ private:
+  struct PublicCall {
+    int index;
+    unsigned long long start_total;
+    std::size_t depth;
+  };
+
+  // Adds the instructions executed since the previous update to the total
+  // and to the innermost function.
+  void Update();
+
+ private:
+  AMX_METER meter_;
+  ucell last_count_;
+  unsigned long long total_;
+  std::vector<cell> functions_stack_;
+  std::vector<PublicCall> publics_stack_;
+  std::map<int, Counter> publics_;
+  std::unordered_map<cell, Counter> functions_;
+};
+
+#endif // !AMXINSTRUCTIONMETER_H
@@ -22,6 +22,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <unordered_map>
 #include "amxopcode.h"
 
 static cell *GetOpcodeMap() {
@@ -47,3 +48,110 @@ cell RelocateAMXOpcode(cell opcode) {
   return opcode;
 }
 
+
+static std::unordered_map<cell, AMXOpcode> GetReverseOpcodeMap() {
+  std::unordered_map<cell, AMXOpcode> map;
+  for (int i = NUM_AMX_OPCODES - 1; i > AMX_OP_NONE; i--) {
+    map[RelocateAMXOpcode(i)] = static_cast<AMXOpcode>(i);
+  }
+  return map;
+}
+
+AMXOpcode UnrelocateAMXOpcode(cell opcode) {
+  static std::unordered_map<cell, AMXOpcode> reverse_map =
+    GetReverseOpcodeMap();
+  std::unordered_map<cell, AMXOpcode>::const_iterator iterator =
+    reverse_map.find(opcode);
+  if (iterator != reverse_map.end()) {
+    return iterator->second;
+  }
+  return AMX_OP_NONE;
+}
+
+int GetAMXOpcodeNumParams(AMXOpcode opcode) {
+  switch (opcode) {
+    case AMX_OP_LOAD_PRI:
+    case AMX_OP_LOAD_ALT:
+    case AMX_OP_LOAD_S_PRI:
+    case AMX_OP_LOAD_S_ALT:
+    case AMX_OP_LREF_PRI:
+    case AMX_OP_LREF_ALT:
+    case AMX_OP_LREF_S_PRI:
+    case AMX_OP_LREF_S_ALT:
+    case AMX_OP_LODB_I:
+    case AMX_OP_CONST_PRI:
+    case AMX_OP_CONST_ALT:
+    case AMX_OP_ADDR_PRI:
+    case AMX_OP_ADDR_ALT:
+    case AMX_OP_STOR_PRI:
+    case AMX_OP_STOR_ALT:
+    case AMX_OP_STOR_S_PRI:
+    case AMX_OP_STOR_S_ALT:
+    case AMX_OP_SREF_PRI:
+    case AMX_OP_SREF_ALT:
+    case AMX_OP_SREF_S_PRI:
+    case AMX_OP_SREF_S_ALT:
+    case AMX_OP_STRB_I:
+    case AMX_OP_LIDX_B:
+    case AMX_OP_IDXADDR_B:
+    case AMX_OP_ALIGN_PRI:
+    case AMX_OP_ALIGN_ALT:
+    case AMX_OP_LCTRL:
+    case AMX_OP_SCTRL:
+    case AMX_OP_PUSH_R:
+    case AMX_OP_PUSH_C:
+    case AMX_OP_PUSH:
+    case AMX_OP_PUSH_S:
+    case AMX_OP_STACK:
+    case AMX_OP_HEAP:
+    case AMX_OP_CALL:
+    case AMX_OP_JUMP:
+    case AMX_OP_JREL:
+    case AMX_OP_JZER:
+    case AMX_OP_JNZ:
+    case AMX_OP_JEQ:
+    case AMX_OP_JNEQ:
+    case AMX_OP_JLESS:
+    case AMX_OP_JLEQ:
+    case AMX_OP_JGRTR:
+    case AMX_OP_JGEQ:
+    case AMX_OP_JSLESS:
+    case AMX_OP_JSLEQ:
+    case AMX_OP_JSGRTR:
+    case AMX_OP_JSGEQ:
+    case AMX_OP_SHL_C_PRI:
+    case AMX_OP_SHL_C_ALT:
+    case AMX_OP_SHR_C_PRI:
+    case AMX_OP_SHR_C_ALT:
+    case AMX_OP_ADD_C:
+    case AMX_OP_SMUL_C:
+    case AMX_OP_ZERO:
+    case AMX_OP_ZERO_S:
+    case AMX_OP_EQ_C_PRI:
+    case AMX_OP_EQ_C_ALT:
+    case AMX_OP_INC:
+    case AMX_OP_INC_S:
+    case AMX_OP_DEC:
+    case AMX_OP_DEC_S:
+    case AMX_OP_MOVS:
+    case AMX_OP_CMPS:
+    case AMX_OP_FILL:
+    case AMX_OP_HALT:
+    case AMX_OP_BOUNDS:
+    case AMX_OP_SYSREQ_C:
+    case AMX_OP_SWITCH:
+    case AMX_OP_PUSH_ADR:
+    case AMX_OP_SYSREQ_D:
+    case AMX_OP_SYMTAG:
+      return 1;
+    case AMX_OP_LINE:
+    case AMX_OP_SRANGE:
+      return 2;
+    case AMX_OP_CASETBL:
+    case AMX_OP_FILE:
+    case AMX_OP_SYMBOL:
+      return -1;
+    default:
+      return 0;
+  }
+}
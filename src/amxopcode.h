@@ -81,4 +81,12 @@ const int NUM_AMX_OPCODES = AMX_OP_LAST_;
 
 cell RelocateAMXOpcode(cell opcode);
 
+// Maps a relocated opcode back to its AMXOpcode value. Returns AMX_OP_NONE
+// if the value doesn't correspond to any opcode.
+AMXOpcode UnrelocateAMXOpcode(cell opcode);
+
+// Returns the number of cell-sized parameters that follow the opcode, or -1
+// for opcodes whose size is stored in the code (CASETBL, FILE and SYMBOL).
+int GetAMXOpcodeNumParams(AMXOpcode opcode);
+
 #endif // !AMXOPCODE_H
@@ -40,6 +40,10 @@ class AMXPathFinder {
 
   std::string Find(AMX *amx);
 
+  const std::list<std::string> &search_paths() const {
+    return search_paths_;
+  }
+
   static AMXPathFinder &shared();
 
  private:
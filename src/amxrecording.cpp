@@ -0,0 +1,384 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+#include "amxrecording.h"
+#include "amxref.h"
+
+using namespace amxrecording;
+
+namespace {
+
+const char kMagic[4] = {'C', 'D', 'R', 'C'};
+
+// Natives often take an array followed by its size; anything larger than
+// this is unlikely to be a size.
+const cell kMaxArraySize = 0x10000;
+
+// Natives that write to an array whose size is not the next argument.
+struct NativeSignature {
+  const char *name;
+  cell array_param;
+  cell size_param;  // 0: modifies a string in place, up to its current length
+};
+
+const NativeSignature kNativeSignatures[] = {
+  {"strcat",    1, 3},
+  {"strdel",    1, 0},
+  {"strins",    1, 4},
+  {"strmid",    1, 5},
+  {"strpack",   1, 3},
+  {"strunpack", 1, 3}
+};
+
+unsigned char *GetData(AMX *amx) {
+  if (amx->data != nullptr) {
+    return amx->data;
+  }
+  return amx->base + reinterpret_cast<AMX_HEADER*>(amx->base)->dat;
+}
+
+cell GetCodeSize(AMX *amx) {
+  AMX_HEADER *hdr = reinterpret_cast<AMX_HEADER*>(amx->base);
+  return hdr->dat - hdr->cod;
+}
+
+bool CompareBlocks(const Block &lhs, const Block &rhs) {
+  return lhs.address < rhs.address;
+}
+
+// Returns the end of the stack, heap or global data region that contains
+// the address, or 0 if it's not a valid data address.
+cell GetRegionEnd(AMX *amx, cell address) {
+  if (address < 0 || address % sizeof(cell) != 0) {
+    return 0;
+  }
+  if (address >= amx->stk && address < amx->stp) {
+    return amx->stp;
+  }
+  if (address >= amx->hlw && address < amx->hea) {
+    return amx->hea;
+  }
+  if (address < amx->hlw) {
+    return amx->hlw;
+  }
+  return 0;
+}
+
+bool IsStackOrHeapAddress(AMX *amx, cell address) {
+  return (address >= amx->stk && address < amx->stp)
+      || (address >= amx->hlw && address < amx->hea);
+}
+
+} // anonymous namespace
+
+AMXRecordingWriter::AMXRecordingWriter()
+  : file_(nullptr)
+{
+}
+
+AMXRecordingWriter::~AMXRecordingWriter() {
+  Close();
+}
+
+bool AMXRecordingWriter::Open(const std::string &path, AMX *amx) {
+  Close();
+  file_ = std::fopen(path.c_str(), "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  std::fwrite(kMagic, 1, sizeof(kMagic), file_);
+  Write(kVersion);
+  Write(GetCodeSize(amx));
+  Write(amx->stp);
+
+  AMXRef amx_ref(amx);
+  int num_signatures = sizeof(kNativeSignatures) / sizeof(*kNativeSignatures);
+  signatures_.assign(amx_ref.GetNumNatives(), -1);
+  for (int i = 0; i < amx_ref.GetNumNatives(); i++) {
+    const char *name = amx_ref.GetNativeName(i);
+    for (int j = 0; name != nullptr && j < num_signatures; j++) {
+      if (std::strcmp(name, kNativeSignatures[j].name) == 0) {
+        signatures_[i] = j;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+void AMXRecordingWriter::Close() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+  pending_.clear();
+}
+
+void AMXRecordingWriter::Flush() {
+  if (file_ != nullptr) {
+    std::fflush(file_);
+  }
+}
+
+void AMXRecordingWriter::WritePublicCall(AMX *amx, int index) {
+  cell *data = reinterpret_cast<cell*>(GetData(amx));
+  std::fputc(PUBLIC_CALL, file_);
+  Write(index);
+  Write(amx->stk);
+  Write(amx->hea);
+  Write(amx->paramcount);
+  Write(data + amx->stk / sizeof(cell), amx->paramcount);
+  Write((amx->hea - amx->hlw) / sizeof(cell));
+  Write(data + amx->hlw / sizeof(cell), (amx->hea - amx->hlw) / sizeof(cell));
+}
+
+void AMXRecordingWriter::WritePublicReturn(int index, int error, cell retval) {
+  std::fputc(PUBLIC_RETURN, file_);
+  Write(index);
+  Write(error);
+  Write(retval);
+}
+
+void AMXRecordingWriter::BeginNativeCall(AMX *amx,
+                                         cell index,
+                                         const cell *params) {
+  const NativeSignature *signature = nullptr;
+  if (index >= 0 && index < static_cast<cell>(signatures_.size())
+                 && signatures_[index] >= 0) {
+    signature = &kNativeSignatures[signatures_[index]];
+  }
+
+  // Save the memory that each argument may point to: an array of the size
+  // given by the native's signature or by the next argument, or else a
+  // single cell. A stack or heap address that follows is another argument
+  // passed by reference rather than a size.
+  std::vector<Block> blocks;
+  unsigned char *data = GetData(amx);
+  cell num_params = params[0] / sizeof(cell);
+  for (cell i = 1; i <= num_params; i++) {
+    cell address = params[i];
+    cell region_end = GetRegionEnd(amx, address);
+    if (region_end == 0) {
+      continue;
+    }
+    cell size = 1;
+    if (signature != nullptr && signature->array_param == i) {
+      if (signature->size_param == 0) {
+        const cell *string = reinterpret_cast<cell*>(data + address);
+        const cell *string_end = reinterpret_cast<cell*>(data + region_end);
+        size = static_cast<cell>(std::find(string, string_end, 0) - string) + 1;
+      } else if (signature->size_param <= num_params) {
+        size = params[signature->size_param];
+      }
+    } else if (i < num_params && params[i + 1] > 0
+                              && params[i + 1] <= kMaxArraySize
+                              && !IsStackOrHeapAddress(amx, params[i + 1])) {
+      size = params[i + 1];
+    }
+    if (size <= 0 || size > kMaxArraySize) {
+      size = 1;
+    }
+    cell end = std::min(address + size * static_cast<cell>(sizeof(cell)),
+                        region_end);
+    Block block;
+    block.address = address;
+    block.cells.resize((end - address) / sizeof(cell));
+    blocks.push_back(block);
+  }
+
+  // Merge overlapping blocks, then save their current contents.
+  std::sort(blocks.begin(), blocks.end(), CompareBlocks);
+  std::vector<Block> merged;
+  for (std::vector<Block>::const_iterator it = blocks.begin();
+       it != blocks.end(); it++) {
+    cell end = it->address + it->cells.size() * sizeof(cell);
+    if (!merged.empty()) {
+      Block &last = merged.back();
+      cell last_end = last.address + last.cells.size() * sizeof(cell);
+      if (it->address <= last_end) {
+        if (end > last_end) {
+          last.cells.resize((end - last.address) / sizeof(cell));
+        }
+        continue;
+      }
+    }
+    merged.push_back(*it);
+  }
+
+  for (std::vector<Block>::iterator it = merged.begin();
+       it != merged.end(); it++) {
+    if (!it->cells.empty()) {
+      std::memcpy(&it->cells[0], data + it->address,
+                  it->cells.size() * sizeof(cell));
+    }
+  }
+
+  pending_.push_back(merged);
+}
+
+void AMXRecordingWriter::WriteNativeReturn(AMX *amx,
+                                           cell index,
+                                           int error,
+                                           cell retval) {
+  if (pending_.empty()) {
+    return;
+  }
+
+  // Record only the runs of cells that have changed.
+  std::vector<Block> changes;
+  cell *data = reinterpret_cast<cell*>(GetData(amx));
+  const std::vector<Block> &saved = pending_.back();
+  for (std::vector<Block>::const_iterator it = saved.begin();
+       it != saved.end(); it++) {
+    const cell *current = data + it->address / sizeof(cell);
+    std::size_t i = 0;
+    while (i < it->cells.size()) {
+      if (current[i] == it->cells[i]) {
+        i++;
+        continue;
+      }
+      Block change;
+      change.address = it->address + i * sizeof(cell);
+      while (i < it->cells.size() && current[i] != it->cells[i]) {
+        change.cells.push_back(current[i++]);
+      }
+      changes.push_back(change);
+    }
+  }
+  pending_.pop_back();
+
+  std::fputc(NATIVE_RETURN, file_);
+  Write(index);
+  Write(error);
+  Write(retval);
+  Write(static_cast<cell>(changes.size()));
+  for (std::vector<Block>::const_iterator it = changes.begin();
+       it != changes.end(); it++) {
+    Write(it->address);
+    Write(static_cast<cell>(it->cells.size()));
+    Write(&it->cells[0], it->cells.size());
+  }
+}
+
+void AMXRecordingWriter::Write(cell value) {
+  std::fwrite(&value, sizeof(value), 1, file_);
+}
+
+void AMXRecordingWriter::Write(const cell *values, std::size_t count) {
+  if (count > 0) {
+    std::fwrite(values, sizeof(*values), count, file_);
+  }
+}
+
+AMXRecordingReader::AMXRecordingReader()
+  : file_(nullptr)
+{
+}
+
+AMXRecordingReader::~AMXRecordingReader() {
+  Close();
+}
+
+bool AMXRecordingReader::Open(const std::string &path, AMX *amx) {
+  Close();
+  file_ = std::fopen(path.c_str(), "rb");
+  if (file_ == nullptr) {
+    return false;
+  }
+
+  char magic[sizeof(kMagic)];
+  cell version, code_size, data_size;
+  if (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic)
+      || std::memcmp(magic, kMagic, sizeof(magic)) != 0
+      || !Read(version) || version != static_cast<cell>(kVersion)
+      || !Read(code_size) || code_size != GetCodeSize(amx)
+      || !Read(data_size) || data_size != amx->stp) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void AMXRecordingReader::Close() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+bool AMXRecordingReader::Read(Record &record) {
+  int type = std::fgetc(file_);
+  record.type = static_cast<RecordType>(type);
+  record.args.clear();
+  record.heap.clear();
+  record.blocks.clear();
+
+  switch (type) {
+    case PUBLIC_CALL:
+      return Read(record.index)
+          && Read(record.stk)
+          && Read(record.hea)
+          && Read(record.args)
+          && Read(record.heap);
+    case PUBLIC_RETURN:
+      return Read(record.index)
+          && Read(record.error)
+          && Read(record.retval);
+    case NATIVE_RETURN: {
+      cell num_blocks;
+      if (!Read(record.index)
+          || !Read(record.error)
+          || !Read(record.retval)
+          || !Read(num_blocks)) {
+        return false;
+      }
+      record.blocks.resize(num_blocks);
+      for (cell i = 0; i < num_blocks; i++) {
+        if (!Read(record.blocks[i].address)
+            || !Read(record.blocks[i].cells)) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AMXRecordingReader::Read(cell &value) {
+  return std::fread(&value, sizeof(value), 1, file_) == 1;
+}
+
+bool AMXRecordingReader::Read(std::vector<cell> &values) {
+  cell count;
+  if (!Read(count) || count < 0) {
+    return false;
+  }
+  values.resize(count);
+  return count == 0
+      || std::fread(&values[0], sizeof(cell), count, file_)
+         == static_cast<std::size_t>(count);
+}
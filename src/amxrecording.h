@@ -0,0 +1,138 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXRECORDING_H
+#define AMXRECORDING_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+
+// A recording is a binary log of everything that comes into a script from the
+// outside: public function calls (with their arguments and the contents of
+// the heap, where string and array arguments live) and the results of native
+// function calls (return values and any memory the native has written to).
+// Given the same .amx file it is enough to re-run the script offline.
+//
+// All numbers are stored in native byte order, as 32-bit integers:
+//
+//   header:  "CDRC" version code_size data_size
+//   'P':     index stk hea num_args args... heap_size heap...
+//   'R':     index error retval
+//   'N':     index error retval num_blocks {address num_cells cells...}...
+//
+// The 'P' record of a public is followed by whatever happens inside of it
+// (native calls and nested publics) and then its 'R' record.
+namespace amxrecording {
+
+const uint32_t kVersion = 1;
+
+enum RecordType {
+  PUBLIC_CALL = 'P',
+  PUBLIC_RETURN = 'R',
+  NATIVE_RETURN = 'N'
+};
+
+struct Block {
+  cell address;
+  std::vector<cell> cells;
+};
+
+struct Record {
+  RecordType type;
+  cell index;
+  cell stk;
+  cell hea;
+  std::vector<cell> args;
+  std::vector<cell> heap;
+  cell error;
+  cell retval;
+  std::vector<Block> blocks;
+};
+
+} // namespace amxrecording
+
+class AMXRecordingWriter {
+ public:
+  AMXRecordingWriter();
+  ~AMXRecordingWriter();
+
+  bool Open(const std::string &path, AMX *amx);
+  void Close();
+  bool IsOpen() const { return file_ != nullptr; }
+  void Flush();
+
+  // Must be called right before amx_Exec() with the arguments already pushed.
+  void WritePublicCall(AMX *amx, int index);
+  void WritePublicReturn(int index, int error, cell retval);
+
+  // BeginNativeCall() saves the memory that the native may write to, based
+  // on its arguments, so that WriteNativeReturn() can record what changed.
+  // An array argument is assumed to be as large as the size argument that
+  // follows it (or that the native's known signature names), anything else
+  // is a single cell.
+  void BeginNativeCall(AMX *amx, cell index, const cell *params);
+  void WriteNativeReturn(AMX *amx, cell index, int error, cell retval);
+
+ private:
+  AMXRecordingWriter(const AMXRecordingWriter &);
+  AMXRecordingWriter &operator=(const AMXRecordingWriter &);
+
+  void Write(cell value);
+  void Write(const cell *values, std::size_t count);
+
+ private:
+  std::FILE *file_;
+  // For each native of the script, its entry in the table of known native
+  // signatures or -1.
+  std::vector<int> signatures_;
+  // Saved memory of the natives that are currently being called (natives
+  // may call publics that call other natives).
+  std::vector<std::vector<amxrecording::Block>> pending_;
+};
+
+class AMXRecordingReader {
+ public:
+  AMXRecordingReader();
+  ~AMXRecordingReader();
+
+  // Fails if the file is not a recording or was made with another script.
+  bool Open(const std::string &path, AMX *amx);
+  void Close();
+
+  bool Read(amxrecording::Record &record);
+
+ private:
+  AMXRecordingReader(const AMXRecordingReader &);
+  AMXRecordingReader &operator=(const AMXRecordingReader &);
+
+  bool Read(cell &value);
+  bool Read(std::vector<cell> &values);
+
+ private:
+  std::FILE *file_;
+};
+
+#endif // !AMXRECORDING_H
@@ -0,0 +1,262 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "amxcodereader.h"
+#include "amxstackanalyzer.h"
+
+namespace {
+
+bool IsUnconditionalJump(AMXOpcode opcode) {
+  switch (opcode) {
+    case AMX_OP_JUMP:
+    case AMX_OP_JUMP_PRI:
+    case AMX_OP_SWITCH:
+    case AMX_OP_RET:
+    case AMX_OP_RETN:
+    case AMX_OP_HALT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsBranch(AMXOpcode opcode) {
+  switch (opcode) {
+    case AMX_OP_JUMP:
+    case AMX_OP_JZER:
+    case AMX_OP_JNZ:
+    case AMX_OP_JEQ:
+    case AMX_OP_JNEQ:
+    case AMX_OP_JLESS:
+    case AMX_OP_JLEQ:
+    case AMX_OP_JGRTR:
+    case AMX_OP_JGEQ:
+    case AMX_OP_JSLESS:
+    case AMX_OP_JSLEQ:
+    case AMX_OP_JSGRTR:
+    case AMX_OP_JSGEQ:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // anonymous namespace
+
+AMXStackAnalyzer::Function::Function()
+  : frame_size(0),
+    dynamic(false),
+    state(kNew),
+    usage(0),
+    deepest_callee(-1),
+    recursive(false)
+{
+}
+
+AMXStackAnalyzer::AMXStackAnalyzer(AMXRef amx): amx_(amx) {}
+
+bool AMXStackAnalyzer::Analyze() {
+  AMXCodeReader reader(amx_);
+  AMXInstruction instruction;
+  Function *function = nullptr;
+  cell depth = 0;
+  cell arg_size = -1;
+  bool reachable = true;
+
+  while (reader.address() < reader.code_size()) {
+    if (!reader.Read(instruction)) {
+      return false;
+    }
+
+    if (instruction.opcode == AMX_OP_PROC) {
+      function = &functions_[instruction.address];
+      branch_depths_.clear();
+      depth = 0;
+      reachable = true;
+    }
+    if (function == nullptr) {
+      // Code before the first function (normally just a HALT).
+      continue;
+    }
+
+    // The depth after an unconditional jump is unknown until we reach code
+    // that is jumped to from somewhere else.
+    std::map<cell, cell>::const_iterator branch =
+      branch_depths_.find(instruction.address);
+    if (branch != branch_depths_.end()) {
+      if (!reachable) {
+        depth = branch->second;
+      }
+      reachable = true;
+    }
+
+    cell last_arg_size = arg_size;
+    arg_size = -1;
+
+    switch (instruction.opcode) {
+      case AMX_OP_PROC:
+      case AMX_OP_PUSH_PRI:
+      case AMX_OP_PUSH_ALT:
+      case AMX_OP_PUSH:
+      case AMX_OP_PUSH_S:
+      case AMX_OP_PUSH_ADR:
+        depth += sizeof(cell);
+        break;
+      case AMX_OP_PUSH_C:
+        // The argument count pushed right before a CALL.
+        arg_size = instruction.GetParam();
+        depth += sizeof(cell);
+        break;
+      case AMX_OP_PUSH_R:
+        depth += instruction.GetParam() * sizeof(cell);
+        break;
+      case AMX_OP_PAMX_OP_PRI:
+      case AMX_OP_PAMX_OP_ALT:
+        depth -= sizeof(cell);
+        break;
+      case AMX_OP_STACK:
+        depth -= instruction.GetParam();
+        break;
+      case AMX_OP_HEAP:
+        depth += instruction.GetParam();
+        break;
+      case AMX_OP_SCTRL:
+        switch (instruction.GetParam()) {
+          case 2: // HEA
+          case 4: // STK
+          case 5: // FRM
+            function->dynamic = true;
+            break;
+        }
+        break;
+      case AMX_OP_CALL: {
+        Call call = {reader.GetTarget(instruction.GetParam()), depth};
+        function->calls.push_back(call);
+        // The callee pops its arguments along with the argument count.
+        if (last_arg_size >= 0) {
+          depth -= last_arg_size + static_cast<cell>(sizeof(cell));
+        }
+        break;
+      }
+      case AMX_OP_SWITCH: {
+        AMXCodeReader table_reader(amx_,
+                                   reader.GetTarget(instruction.GetParam()));
+        AMXInstruction table;
+        if (table_reader.Read(table) && table.opcode == AMX_OP_CASETBL) {
+          std::vector<cell> targets;
+          for (int i = 1; i < table.num_params; i += 2) {
+            targets.push_back(reader.GetTarget(table.GetParam(i)));
+          }
+          MarkBranchTargets(targets, depth);
+        }
+        break;
+      }
+      default:
+        if (IsBranch(instruction.opcode)) {
+          std::vector<cell> targets(1,
+            reader.GetTarget(instruction.GetParam()));
+          MarkBranchTargets(targets, depth);
+        }
+        break;
+    }
+
+    if (reachable) {
+      function->frame_size = std::max(function->frame_size, depth);
+    }
+    if (IsUnconditionalJump(instruction.opcode)) {
+      reachable = false;
+    }
+  }
+
+  return true;
+}
+
+void AMXStackAnalyzer::MarkBranchTargets(const std::vector<cell> &targets,
+                                         cell depth) {
+  for (std::vector<cell>::const_iterator it = targets.begin();
+       it != targets.end(); ++it) {
+    branch_depths_.insert(std::make_pair(*it, depth));
+  }
+}
+
+AMXStackAnalyzer::Usage AMXStackAnalyzer::GetUsage(cell address) {
+  Usage usage;
+  usage.size = 2 * sizeof(cell);
+  usage.recursive = false;
+  usage.dynamic = false;
+
+  std::map<cell, Function>::iterator it = functions_.find(address);
+  if (it == functions_.end()) {
+    return usage;
+  }
+
+  Visit(it->second);
+  usage.size += it->second.usage;
+  usage.recursive = it->second.recursive;
+  usage.dynamic = it->second.dynamic;
+
+  while (it != functions_.end()
+         && std::find(usage.path.begin(), usage.path.end(), it->first)
+              == usage.path.end()) {
+    usage.path.push_back(it->first);
+    it = functions_.find(it->second.deepest_callee);
+  }
+
+  return usage;
+}
+
+void AMXStackAnalyzer::Visit(Function &function) {
+  if (function.state != Function::kNew) {
+    return;
+  }
+
+  function.state = Function::kVisiting;
+  function.usage = function.frame_size;
+
+  for (std::vector<Call>::const_iterator it = function.calls.begin();
+       it != function.calls.end(); ++it) {
+    cell usage = it->depth + sizeof(cell);
+    std::map<cell, Function>::iterator callee = functions_.find(it->address);
+    if (callee != functions_.end()) {
+      if (callee->second.state == Function::kVisiting) {
+        // Count one level of recursion; there's no way to tell how deep it
+        // goes at run time.
+        recursive_functions_.insert(callee->first);
+        function.recursive = true;
+      } else {
+        Visit(callee->second);
+        usage += callee->second.usage;
+        function.recursive = function.recursive || callee->second.recursive;
+        function.dynamic = function.dynamic || callee->second.dynamic;
+      }
+    }
+    if (usage > function.usage) {
+      function.usage = usage;
+      function.deepest_callee = it->address;
+    }
+  }
+
+  function.state = Function::kDone;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXSTACKANALYZER_H
+#define AMXSTACKANALYZER_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <amx/amx.h>
+#include "amxref.h"
+
+// Estimates the worst-case stack usage of an AMX from its code: the frame
+// size of every function is derived from the STACK, HEAP, PUSH and POP
+// instructions it executes and the calls it makes are collected into a call
+// graph. Heap allocations are counted too because the heap and the stack
+// share the same memory region.
+class AMXStackAnalyzer {
+ public:
+  struct Usage {
+    cell size;              // in bytes
+    bool recursive;         // reaches recursion, so the size is a lower bound
+    bool dynamic;           // reaches code that modifies STK/FRM/HEA directly
+    std::vector<cell> path; // the deepest call chain
+  };
+
+  explicit AMXStackAnalyzer(AMXRef amx);
+
+  // Decodes the code section and builds the call graph. Returns false if
+  // the code contains an invalid instruction.
+  bool Analyze();
+
+  // Returns the worst-case usage of a call to the function at the specified
+  // address, including the return address and the argument count pushed by
+  // the caller but not the arguments themselves.
+  Usage GetUsage(cell address);
+
+  // Returns the addresses of functions that call themselves, directly or
+  // through other functions. Only valid after GetUsage() has been called on
+  // the functions of interest.
+  const std::set<cell> &recursive_functions() const {
+    return recursive_functions_;
+  }
+
+ private:
+  struct Call {
+    cell address;
+    cell depth;
+  };
+
+  struct Function {
+    enum State { kNew, kVisiting, kDone };
+
+    Function();
+
+    cell frame_size;
+    std::vector<Call> calls;
+    bool dynamic; // modifies STK/FRM/HEA itself or calls such code
+
+    State state;
+    cell usage;
+    cell deepest_callee;
+    bool recursive;
+  };
+
+  void MarkBranchTargets(const std::vector<cell> &targets, cell depth);
+  void Visit(Function &function);
+
+ private:
+  AMXRef amx_;
+  std::map<cell, Function> functions_;
+  std::map<cell, cell> branch_depths_;
+  std::set<cell> recursive_functions_;
+};
+
+#endif // !AMXSTACKANALYZER_H
@@ -24,10 +24,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <functional>
-#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -35,6 +36,8 @@
 #include "amxopcode.h"
 #include "amxref.h"
 #include "amxstacktrace.h"
+#include "amxstatetable.h"
+#include "amxsymbolindex.h"
 
 namespace {
 
@@ -114,7 +117,8 @@ AMXStackFrame::AMXStackFrame(AMXRef amx, cell address)
    address_(0),
    return_address_(0),
    callee_address_(0),
-   caller_address_(0)
+   caller_address_(0),
+   previous_address_(0)
 {
   if (IsStackAddress(amx_, address)) {
     address_ = address;
@@ -137,7 +141,8 @@ AMXStackFrame::AMXStackFrame(AMXRef amx,
    address_(0),
    return_address_(0),
    callee_address_(0),
-   caller_address_(0)
+   caller_address_(0),
+   previous_address_(0)
 {
   if (IsStackAddress(amx_, address)) {
     address_ = address;
@@ -153,8 +158,15 @@ AMXStackFrame::AMXStackFrame(AMXRef amx,
   }
 }
 
+cell AMXStackFrame::previous_address() const {
+  if (previous_address_ != 0) {
+    return previous_address_;
+  }
+  return GetPreviousFrameSafe(amx_, address_);
+}
+
 AMXStackFrame AMXStackFrame::GetPrevious() const {
-  return AMXStackFrame(amx_, GetPreviousFrameSafe(amx_, address_));
+  return AMXStackFrame(amx_, previous_address());
 }
 
 void AMXStackFrame::Print(std::ostream &stream,
@@ -163,16 +175,90 @@ void AMXStackFrame::Print(std::ostream &stream,
   printer.Print(*this);
 }
 
-AMXStackTrace::AMXStackTrace(AMXRef amx, cell frame, int max_depth)
- : current_frame_(amx, frame),
+AMXStackWalker::AMXStackWalker(AMXRef amx, cell frm, cell cip)
+ : amx_(amx),
+   data_(amx.GetData()),
+   code_(amx.GetCode()),
+   stack_lower_(amx.GetHlw()),
+   stack_upper_(amx.GetStp()),
+   code_size_(amx.GetHeader()->dat - amx.GetHeader()->cod),
+   address_(0),
+   frm_(frm),
+   cip_(cip)
+{
+}
+
+bool AMXStackWalker::ReadStack(cell address, cell &value) const {
+  if (address < stack_lower_
+      || address > stack_upper_ - static_cast<cell>(sizeof(cell))
+      || address % sizeof(cell) != 0) {
+    return false;
+  }
+  value = *reinterpret_cast<const cell*>(data_ + address);
+  return true;
+}
+
+cell AMXStackWalker::GetCalleeAddress(cell return_address) const {
+  // The return address follows the operand of the CALL instruction, which
+  // is an absolute (relocated) address.
+  if (return_address < static_cast<cell>(sizeof(cell))
+      || return_address > code_size_
+      || return_address % sizeof(cell) != 0) {
+    return 0;
+  }
+  cell target = *reinterpret_cast<const cell*>(code_ + return_address
+                                               - sizeof(cell));
+  target -= reinterpret_cast<cell>(code_);
+  if (target < 0 || target >= code_size_) {
+    return 0;
+  }
+  return target;
+}
+
+bool AMXStackWalker::Next(AMXStackFrame &frame) {
+  if (cip_ == 0) {
+    return false;
+  }
+
+  // The caller of the current function is known from the return address
+  // stored in its frame.
+  cell return_address = 0;
+  cell caller_address = 0;
+  if (ReadStack(frm_ + sizeof(cell), return_address) && return_address != 0) {
+    caller_address = GetCalleeAddress(return_address);
+  }
+
+  frame = AMXStackFrame(amx_,
+                        address_,
+                        cip_,
+                        GetCalleeAddress(cip_),
+                        caller_address);
+  frame.set_previous_address(frm_);
+
+  cell previous_frm = 0;
+  if (!ReadStack(frm_, previous_frm) || previous_frm <= frm_) {
+    return_address = 0;
+  }
+  address_ = frm_;
+  frm_ = previous_frm;
+  cip_ = return_address;
+  return true;
+}
+
+AMXStackTrace::AMXStackTrace(AMXRef amx, cell frm, cell cip, int max_depth)
+ : walker_(amx, frm, cip),
+   current_frame_(amx, 0),
    max_depth_(max_depth),
    frame_index_(0)
 {
+  walker_.Next(current_frame_);
 }
 
 bool AMXStackTrace::MoveNext() {
-  if (frame_index_ < max_depth_) {
-    current_frame_ = current_frame_.GetPrevious();
+  if (max_depth_ < 0 || frame_index_ < max_depth_) {
+    if (!walker_.Next(current_frame_)) {
+      current_frame_ = AMXStackFrame(current_frame_.amx(), 0);
+    }
     frame_index_++;
     return true;
   }
@@ -183,24 +269,7 @@ AMXStackTrace GetAMXStackTrace(AMXRef amx,
                                cell frm,
                                cell cip,
                                int max_depth) {
-  // Use a fake frame, hopefully without clobbering anything in silly code.
-  cell stk = amx.GetStk();
-  cell hlw = amx.GetHea();
-  if (amx.CheckStack() && amx.GetStackSpaceLeft() >= (2 * sizeof(cell))) {
-    amx.SetStk(hlw + (2 * sizeof(cell)));
-    amx.PushStack(cip);
-    amx.PushStack(frm);
-    amx.SetFrm(hlw);
-  }
-
-  AMXStackTrace trace(amx, amx.GetFrm(), max_depth);
-
-  if (amx.CheckStack()) {
-    amx.SetStk(stk);
-    amx.SetFrm(frm);
-  }
-
-  return trace;
+  return AMXStackTrace(amx, frm, cip, max_depth);
 }
 
 namespace {
@@ -259,46 +328,29 @@ cell GetMaxStringSize(AMXRef amx, cell address) {
   return amx.GetHeader()->stp - address;
 }
 
-std::string GetPackedString(const cell *string, std::size_t size) {
-  std::string s;
+// Formats the string stored at the specified address up to the first
+// non-printable character; strings longer than max_length are cut off with
+// "...". For packed strings size is a number of characters, otherwise it is
+// a number of cells.
+void FormatString(FormatBuffer &buffer, const cell *string, std::size_t size,
+                  bool packed, std::size_t max_length) {
   for (std::size_t i = 0; i < size; i++) {
-    cell cp = string[i / sizeof(cell)] >>
-              ((sizeof(cell) - i % sizeof(cell) - 1) * 8);
-    char cu = IsPrintableChar(cp) ? cp : '\0';
-    if (cu == '\0') {
-      break;
+    char c;
+    if (packed) {
+      cell cp = string[i / sizeof(cell)] >>
+                ((sizeof(cell) - i % sizeof(cell) - 1) * 8);
+      c = IsPrintableChar(cp) ? static_cast<char>(cp) : '\0';
+    } else {
+      c = IsPrintableChar(string[i]) ? static_cast<char>(string[i]) : '\0';
     }
-    s.push_back(cu);
-  }
-  return s;
-}
-
-std::string GetUnpackedString(const cell *string, std::size_t size) {
-  std::string s;
-  for (std::size_t i = 0; i < size; i++) {
-    char c = IsPrintableChar(string[i]) ? string[i] : '\0';
     if (c == '\0') {
       break;
     }
-    s.push_back(c);
-  }
-  return s;
-}
-
-void GetStringContents(AMXRef amx, cell address, std::size_t size,
-                       std::string &string, bool &packed) {
-
-  cell *ptr = GetDataPtr(amx, address);
-  if (ptr != nullptr) {
-    packed = IsPackedString(ptr);
-    if (size == 0) {
-      size = GetMaxStringSize(amx, address);
-    }
-    if (packed) {
-      string = GetPackedString(ptr, size);
-    } else {
-      string = GetUnpackedString(ptr, size);
+    if (i == max_length) {
+      buffer.Append("...");
+      break;
     }
+    buffer.Append(c);
   }
 }
 
@@ -318,144 +370,116 @@ bool UsesAutomata(const AMXStackFrame &frame) {
   return GetStateVarAddress(frame.amx(), frame.caller_address()) > 0;
 }
 
-class CaseTable {
- public:
-  struct Record {
-    cell value;
-    cell address;
-  };
-  CaseTable(AMXRef amx, cell address) {
-    Record *table = reinterpret_cast<Record*>(amx.GetCode()
-                                              + address + sizeof(cell));
-    int num_records = table[0].value;
-    records_.resize(num_records + 1);
-    for (int i = 0; i <= num_records; i++) {
-      records_[i].value = table[i].value;
-      records_[i].address = table[i].address
-                            - reinterpret_cast<cell>(amx.GetCode());
-    }
-  }
-  int GetNumRecords() const {
-    return static_cast<int>(records_.size());
-  }
-  cell GetValueAt(cell index) const {
-    return records_[index].value;
-  }
-  cell GetAddressAt(cell index) const {
-    return records_[index].address;
-  }
- private:
-  std::vector<Record> records_;
-};
-
-cell GetStateTableAddress(AMXRef amx, cell function_address) {
-  return function_address + 4 * sizeof(cell);
-}
-
-cell GetStateTableAddressSafe(AMXRef amx, cell function_address) {
-  cell state_table_address = GetStateTableAddress(amx, function_address);
-  if (IsCodeAddress(amx, state_table_address)) {
-    return state_table_address;
-  }
-  return 0;
-}
-
 cell GetRealFunctionAddress(AMXRef amx,
                             cell function_address,
                             cell return_address) {
-  cell state_table_address = GetStateTableAddressSafe(amx, function_address);
-  if (state_table_address != 0) {
-    CaseTable state_table(amx, state_table_address);
-    for (int i = 0; i < state_table.GetNumRecords(); i++) {
-      if (state_table.GetAddressAt(i) > return_address) {
-        return state_table.GetAddressAt(i - (i > 0));
-      }
-    }
+  std::shared_ptr<const AMXStateTable> state_table =
+    AMXStateTables::GetTable(amx, function_address);
+  const AMXStateTable::Implementation *impl =
+    state_table->FindImplementation(return_address);
+  if (impl != nullptr) {
+    return impl->address;
   }
   return -1;
 }
 
-std::vector<cell> GetStateIDs(AMXRef amx,
-                              cell function_address,
-                              cell return_address) {
-  std::vector<cell> states;
-
-  cell real_address = GetRealFunctionAddress(amx, function_address,
-                                                  return_address);
-  if (real_address == 0) {
-    return states;
+const std::vector<cell> *GetStateIDs(const AMXStateTable &state_table,
+                                     cell return_address) {
+  const AMXStateTable::Implementation *impl =
+    state_table.FindImplementation(return_address);
+  if (impl != nullptr) {
+    return &impl->state_ids;
   }
+  return nullptr;
+}
 
-  cell state_table_address = GetStateTableAddressSafe(amx, function_address);
-  if (state_table_address == 0) {
-    return states;
-  }
+} // anonymous namespace
 
-  CaseTable state_table(amx, state_table_address);
-  for (int i = 0; i < state_table.GetNumRecords(); i++) {
-    if (state_table.GetAddressAt(i) == real_address) {
-      if (i > 0) {
-        states.push_back(state_table.GetValueAt(i));
-      } else {
-        states.push_back(0); // fallback
-      }
-    } else {
-      if (states.size() > 0) {
-        // State table entries appear to be sorted by address, so if
-        // this one doesn't match here's no point in checking the rest.
-        break;
-      }
+// Flushes the output to the stream (if any) when the outermost Print*()
+// call returns, so that the printer can be mixed with direct writes to the
+// stream.
+class AMXStackFramePrinter::ScopedFlush {
+ public:
+  explicit ScopedFlush(AMXStackFramePrinter *printer) : printer_(printer) {
+    printer_->depth_++;
+  }
+  ~ScopedFlush() {
+    if (--printer_->depth_ == 0 && printer_->stream_buffer_ != nullptr) {
+      printer_->stream_buffer_->Flush();
     }
   }
-  return states;
-}
-
-} // anonymous namespace
+ private:
+  AMXStackFramePrinter *printer_;
+};
 
 AMXStackFramePrinter::AMXStackFramePrinter(std::ostream &stream,
                                            const AMXDebugInfo &debug_info)
-  : stream_(stream),
-    debug_info_(debug_info)
+  : stream_buffer_(new StreamFormatBuffer(stream)),
+    buffer_(*stream_buffer_),
+    debug_info_(debug_info),
+    depth_(0)
+{
+}
+
+AMXStackFramePrinter::AMXStackFramePrinter(FormatBuffer &buffer,
+                                           const AMXDebugInfo &debug_info)
+  : buffer_(buffer),
+    debug_info_(debug_info),
+    depth_(0)
 {
 }
 
+AMXStackFramePrinter::~AMXStackFramePrinter() {
+}
+
+const char *AMXStackFramePrinter::GetTagName(int32_t tag_id) const {
+  AMXDebugTag tag = debug_info_.GetTag(tag_id);
+  return tag ? tag.GetNamePtr() : "";
+}
+
 void AMXStackFramePrinter::Print(const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
+
   PrintReturnAddress(frame);
-  stream_ << " in ";
+  buffer_.Append(" in ");
 
   PrintCallerNameAndArguments(frame);
 
   if (debug_info_.IsLoaded() && UsesAutomata(frame)) {
-    stream_ << " ";
+    buffer_.Append(" ");
     PrintState(frame);
   }
 
   if (debug_info_.IsLoaded() && frame.return_address() != 0) {
-    stream_ << " at ";
+    buffer_.Append(" at ");
     PrintSourceLocation(frame.return_address());
   }
 }
 
 void AMXStackFramePrinter::PrintTag(const AMXDebugSymbol &symbol) {
-  std::string tag_name = debug_info_.GetTagName(symbol.GetTag());
-  if (!tag_name.empty() && tag_name != "_") {
-    stream_ << tag_name << ":";
+  ScopedFlush flush(this);
+
+  const char *tag_name = GetTagName(symbol.GetTag());
+  if (tag_name[0] != '\0' && std::strcmp(tag_name, "_") != 0) {
+    buffer_.Append(tag_name).Append(':');
   }
 }
 
 void AMXStackFramePrinter::PrintAddress(cell address) {
-  char old_fill = stream_.fill('0');
-  stream_ << std::hex << std::setw(sizeof(cell) * 2) << address << std::dec;
-  stream_.fill(old_fill);
+  ScopedFlush flush(this);
+  buffer_.AppendHex(static_cast<ucell>(address), sizeof(cell) * 2);
 }
 
 void AMXStackFramePrinter::PrintReturnAddress(const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
   PrintAddress(frame.return_address());
 }
 
 void AMXStackFramePrinter::PrintCallerName(const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
+
   if (IsMain(frame.amx(), frame.caller_address())) {
-    stream_ << "main";
+    buffer_.Append("main");
     return;
   }
 
@@ -468,10 +492,10 @@ void AMXStackFramePrinter::PrintCallerName(const AMXStackFrame &frame) {
     if (caller) {
       if (IsPublicFunction(frame.amx(), caller.GetCodeStart())
           && !IsMain(frame.amx(), caller.GetCodeStart())) {
-        stream_ << "public ";
+        buffer_.Append("public ");
       }
       PrintTag(caller);
-      stream_ << caller.GetName();
+      buffer_.Append(caller.GetNamePtr());
       return;
     }
   }
@@ -481,75 +505,99 @@ void AMXStackFramePrinter::PrintCallerName(const AMXStackFrame &frame) {
     name = frame.amx().FindPublic(frame.caller_address());
   }
   if (name != nullptr) {
-    stream_ << "public " << name;
+    buffer_.Append("public ").Append(name);
+    return;
+  }
+
+  // Scripts compiled without debug info may still have an index of
+  // function boundaries. The caller address is unknown for the outermost
+  // frame, but its code address is within the same function.
+  cell address = frame.caller_address() != 0 ? frame.caller_address()
+                                             : frame.return_address();
+  const AMXSymbolIndex::Symbol *symbol =
+    AMXSymbolIndex::Lookup(frame.amx(), address);
+  if (symbol != nullptr && !symbol->name.empty()) {
+    if (symbol->is_public) {
+      buffer_.Append("public ");
+    }
+    buffer_.Append(symbol->name.c_str());
   } else {
-    stream_ << "??";
+    buffer_.Append("??");
   }
 }
 
 void AMXStackFramePrinter::PrintCallerNameAndArguments(
     const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
+
   PrintCallerName(frame);
-  stream_ << " (";
+  buffer_.Append(" (");
   PrintArgumentList(frame);
-  stream_ << ")";
+  buffer_.Append(")");
 }
 
 void AMXStackFramePrinter::PrintArgument(const AMXStackFrame &frame,
                                          int index) {
+  ScopedFlush flush(this);
   PrintArgumentValue(frame, index);
 }
 
 void AMXStackFramePrinter::PrintArgument(const AMXStackFrame &frame,
                                          const AMXDebugSymbol &arg,
                                          int index) {
+  ScopedFlush flush(this);
+
   if (arg.IsReference()) {
-    stream_ << "&";
+    buffer_.Append("&");
   }
 
   PrintTag(arg);
-  stream_ << arg.GetName();
-
-  if (!arg.IsVariable()) {
-    std::vector<AMXDebugSymbolDim> dims = arg.GetDims();
-
-    if (arg.IsArray() || arg.IsArrayRef()) {
-      for (std::size_t i = 0; i < dims.size(); ++i) {
-        if (dims[i].GetSize() == 0) {
-          stream_ << "[]";
-        } else {
-          std::string tag = debug_info_.GetTagName(dims[i].GetTag()) + ":";
-          if (tag == "_:") tag.clear();
-          stream_ << "[" << tag << dims[i].GetSize() << "]";
+  buffer_.Append(arg.GetNamePtr());
+
+  if (arg.IsArray() || arg.IsArrayRef()) {
+    for (int i = 0; i < arg.GetNumDims(); ++i) {
+      AMXDebugSymbolDim dim = arg.GetDim(i);
+      if (dim.GetSize() == 0) {
+        buffer_.Append("[]");
+      } else {
+        const char *tag_name = GetTagName(dim.GetTag());
+        buffer_.Append("[");
+        if (std::strcmp(tag_name, "_") != 0) {
+          buffer_.Append(tag_name).Append(':');
         }
+        buffer_.AppendInt(dim.GetSize()).Append("]");
       }
     }
   }
 
-  stream_ << "=";
+  buffer_.Append("=");
   PrintArgumentValue(frame, arg, index);
 }
 
-void AMXStackFramePrinter::PrintValue(const std::string &tag_name,
-                                      cell value) {
-  if (tag_name == "bool") {
-    stream_ << (value ? "true" : "false");
-  } else if (tag_name == "Float") {
-    stream_ << std::fixed << std::setprecision(5) << amx_ctof(value);
+void AMXStackFramePrinter::PrintValue(const char *tag_name, cell value) {
+  ScopedFlush flush(this);
+
+  if (std::strcmp(tag_name, "bool") == 0) {
+    buffer_.Append(value ? "true" : "false");
+  } else if (std::strcmp(tag_name, "Float") == 0) {
+    buffer_.AppendFixed(amx_ctof(value), 5);
   } else {
-    stream_ << value;
+    buffer_.AppendInt(value);
   }
 }
 
 void AMXStackFramePrinter::PrintArgumentValue(const AMXStackFrame &frame,
                                               int index) {
-  stream_ << GetArgumentValue(frame, index);
+  ScopedFlush flush(this);
+  buffer_.AppendInt(GetArgumentValue(frame, index));
 }
 
 void AMXStackFramePrinter::PrintArgumentValue(const AMXStackFrame &frame,
                                               const AMXDebugSymbol &arg,
                                               int index) {
-  std::string tag_name = debug_info_.GetTagName(arg.GetTag());
+  ScopedFlush flush(this);
+
+  const char *tag_name = GetTagName(arg.GetTag());
   cell value = GetArgumentValue(frame, index);
 
   if (arg.IsVariable()) {
@@ -557,43 +605,45 @@ void AMXStackFramePrinter::PrintArgumentValue(const AMXStackFrame &frame,
     return;
   }
 
-  stream_ << "@";
+  buffer_.Append("@");
   PrintAddress(value);
 
   if (arg.IsReference()) {
     if (cell *ptr = GetDataPtr(frame.amx(), value)) {
-      stream_ << " ";
+      buffer_.Append(" ");
       PrintValue(tag_name, *ptr);
     }
     return;
   }
 
   if (arg.IsArray() || arg.IsArrayRef()) {
-    std::vector<AMXDebugSymbolDim> dims = arg.GetDims();
-
     // Try to filter out non-printable arrays (e.g. non-strings).
     // This doesn't work 100% of the time, but it's better than nothing.
-    if (dims.size() == 1
-        && tag_name == "_"
-        && debug_info_.GetTagName(dims[0].GetTag()) == "_")
+    if (arg.GetNumDims() == 1
+        && std::strcmp(tag_name, "_") == 0
+        && std::strcmp(GetTagName(arg.GetDim(0).GetTag()), "_") == 0)
     {
-      std::string string;
-      bool packed = false;
-
-      GetStringContents(frame.amx(), value, dims[0].GetSize(), string, packed);
-      stream_ << (packed ? " !" : " ");
-
       static const std::size_t kMaxString = 80;
-      if (string.length() > kMaxString) {
-        string.replace(kMaxString, string.length() - kMaxString, "...");
-      }
 
-      stream_ << "\"" << string << "\"";
+      cell *ptr = GetDataPtr(frame.amx(), value);
+      bool packed = ptr != nullptr && IsPackedString(ptr);
+      buffer_.Append(packed ? " !" : " ");
+      buffer_.Append("\"");
+      if (ptr != nullptr) {
+        std::size_t size = arg.GetDim(0).GetSize();
+        if (size == 0) {
+          size = GetMaxStringSize(frame.amx(), value);
+        }
+        FormatString(buffer_, ptr, size, packed, kMaxString);
+      }
+      buffer_.Append("\"");
     }
   }
 }
 
 void AMXStackFramePrinter::PrintArgumentList(const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
+
   AMXStackFrame prev_frame = frame.GetPrevious();
 
   if (prev_frame.address() == 0) {
@@ -611,7 +661,6 @@ void AMXStackFramePrinter::PrintArgumentList(const AMXStackFrame &frame) {
                                           frame.return_address());
   }
 
-  std::vector<AMXDebugSymbol> args;
   cell num_actual_args = GetNumArguments(frame.amx(), prev_frame.address());
   if (num_actual_args < 0) {
     // For better compatibility with YSI, if the the count is negative use
@@ -621,12 +670,14 @@ void AMXStackFramePrinter::PrintArgumentList(const AMXStackFrame &frame) {
   }
   cell num_printed_args = std::min(10, num_actual_args);
 
+  // args_ is reused between frames to avoid reallocating it every time.
+  args_.clear();
   if (debug_info_.IsLoaded()) {
     std::remove_copy_if(debug_info_.GetSymbols().begin(),
                         debug_info_.GetSymbols().end(),
-                        std::back_inserter(args),
+                        std::back_inserter(args_),
                         std::not1(IsArgumentOf(func_address)));
-    std::sort(args.begin(), args.end());
+    std::sort(args_.begin(), args_.end());
   }
 
   // Print a comma-separated list of arguments and their values. If debug
@@ -634,10 +685,10 @@ void AMXStackFramePrinter::PrintArgumentList(const AMXStackFrame &frame) {
   // are printed).
   for (cell i = 0; i < num_printed_args; i++) {
     if (i > 0) {
-      stream_ << ", ";
+      buffer_.Append(", ");
     }
-    if (debug_info_.IsLoaded() && i < static_cast<cell>(args.size())) {
-      PrintArgument(prev_frame, args[i], i);
+    if (debug_info_.IsLoaded() && i < static_cast<cell>(args_.size())) {
+      PrintArgument(prev_frame, args_[i], i);
     } else {
       PrintArgument(prev_frame, i);
     }
@@ -646,43 +697,52 @@ void AMXStackFramePrinter::PrintArgumentList(const AMXStackFrame &frame) {
   cell num_more_args = num_actual_args - num_printed_args;
   if (num_more_args > 0) {
     if (num_printed_args != 0) {
-      stream_ << ", ";
+      buffer_.Append(", ");
     }
-    stream_ << "... <"
-            << num_more_args
-            << " more " << (num_more_args == 1 ? "argument" : "arguments")
-            << ">";
+    buffer_.Append("... <")
+           .AppendInt(num_more_args)
+           .Append(" more ")
+           .Append(num_more_args == 1 ? "argument" : "arguments")
+           .Append(">");
   }
 }
 
 void AMXStackFramePrinter::PrintState(const AMXStackFrame &frame) {
+  ScopedFlush flush(this);
+
   AMXDebugAutomaton automaton = debug_info_.GetAutomaton(
     GetStateVarAddress(frame.amx(), frame.caller_address()));
   if (automaton) {
-    std::vector<cell> states = GetStateIDs(frame.amx(),
-                                           frame.caller_address(),
-                                           frame.return_address());
-    if (!states.empty()) {
-      stream_ << "<" << automaton.GetName() << ":";
-      for (std::size_t i = 0; i < states.size(); i++ ) {
+    std::shared_ptr<const AMXStateTable> state_table =
+      AMXStateTables::GetTable(frame.amx(), frame.caller_address());
+    const std::vector<cell> *states =
+      GetStateIDs(*state_table, frame.return_address());
+    if (states != nullptr && !states->empty()) {
+      buffer_.Append("<").Append(automaton.GetNamePtr()).Append(":");
+      for (std::size_t i = 0; i < states->size(); i++ ) {
         if (i > 0) {
-          stream_ << ", ";
+          buffer_.Append(", ");
         }
         AMXDebugState state =
-          debug_info_.GetState(automaton.GetID(), states[i]);
+          debug_info_.GetState(automaton.GetID(), (*states)[i]);
         if (state) {
-          stream_ << state.GetName();
+          buffer_.Append(state.GetNamePtr());
         }
       }
-      stream_ << ">";
+      buffer_.Append(">");
     }
   }
 }
 
 void AMXStackFramePrinter::PrintSourceLocation(cell address) {
-  std::string filename = debug_info_.GetFileName(address);
-  if (filename.empty()) {
-    filename.assign("<unknown file>");
+  ScopedFlush flush(this);
+
+  AMXDebugFile file = debug_info_.GetFile(address);
+  const char *filename = file ? file.GetNamePtr() : "";
+  if (filename[0] == '\0') {
+    filename = "<unknown file>";
   }
-  stream_ << filename << ":" << debug_info_.GetLineNumber(address) + 1;
+  buffer_.Append(filename)
+         .Append(":")
+         .AppendInt(debug_info_.GetLineNumber(address) + 1);
 }
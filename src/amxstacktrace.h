@@ -26,9 +26,11 @@
 #define AMXSTACKTRACE_H
 
 #include <iosfwd>
+#include <memory>
+#include <vector>
+#include "amxdebuginfo.h"
 #include "amxref.h"
-
-class AMXDebugInfo;
+#include "formatbuffer.h"
 
 class AMXStackFrame {
  public:
@@ -67,6 +69,14 @@ class AMXStackFrame {
     caller_address_ = caller_address;
   }
 
+  // The frame of the function this frame is in. By default it is read from
+  // the stack at address().
+  cell previous_address() const;
+
+  void set_previous_address(cell previous_address) {
+    previous_address_ = previous_address;
+  }
+
   AMXStackFrame GetPrevious() const;
 
   void Print(std::ostream &stream, const AMXDebugInfo &debug_info) const;
@@ -77,11 +87,41 @@ class AMXStackFrame {
   cell return_address_;
   cell callee_address_;
   cell caller_address_;
+  cell previous_address_;
+};
+
+// Walks the call chain starting at the specified frame and code address
+// without modifying the AMX. Every read is checked against the bounds of the
+// stack and code taken when the walker is created, and frames must strictly
+// increase, so the walk terminates even if the script is running in another
+// thread (although the frames may then be inconsistent).
+class AMXStackWalker {
+ public:
+  AMXStackWalker(AMXRef amx, cell frm, cell cip);
+
+  // Stores the next (outer) frame in frame. Returns false when there are no
+  // more frames.
+  bool Next(AMXStackFrame &frame);
+
+ private:
+  bool ReadStack(cell address, cell &value) const;
+  cell GetCalleeAddress(cell return_address) const;
+
+ private:
+  AMXRef amx_;
+  const unsigned char *data_;
+  const unsigned char *code_;
+  cell stack_lower_;
+  cell stack_upper_;
+  cell code_size_;
+  cell address_;
+  cell frm_;
+  cell cip_;
 };
 
 class AMXStackTrace {
  public:
-  AMXStackTrace(AMXRef amx, cell frame, int max_depth);
+  AMXStackTrace(AMXRef amx, cell frm, cell cip, int max_depth);
 
   bool MoveNext();
 
@@ -90,20 +130,28 @@ class AMXStackTrace {
   }
 
  private:
+  AMXStackWalker walker_;
   AMXStackFrame current_frame_;
   int max_depth_;
   int frame_index_;
 };
 
+// A negative max_depth means no limit. The walk always terminates because
+// each frame must be above the previous one.
 AMXStackTrace GetAMXStackTrace(AMXRef amx,
                                cell frm,
                                cell cip,
                                int max_depth);
 
+// Formats stack frames into a FormatBuffer, or into a stream through a
+// small internal buffer.
 class AMXStackFramePrinter {
  public:
   AMXStackFramePrinter(std::ostream &stream,
                        const AMXDebugInfo &debug_info);
+  AMXStackFramePrinter(FormatBuffer &buffer,
+                       const AMXDebugInfo &debug_info);
+  ~AMXStackFramePrinter();
 
   void Print(const AMXStackFrame &frame);
 
@@ -120,7 +168,7 @@ class AMXStackFramePrinter {
                      const AMXDebugSymbol &arg,
                      int index);
 
-  void PrintValue(const std::string &tag_name, cell value);
+  void PrintValue(const char *tag_name, cell value);
   void PrintArgumentValue(const AMXStackFrame &frame, int index);
   void PrintArgumentValue(const AMXStackFrame &frame,
                           const AMXDebugSymbol &arg,
@@ -133,8 +181,21 @@ class AMXStackFramePrinter {
   void PrintSourceLocation(cell address);
 
  private:
-  std::ostream &stream_;
+  class ScopedFlush;
+  friend class ScopedFlush;
+
+  const char *GetTagName(int32_t tag_id) const;
+
+ private:
+  AMXStackFramePrinter(const AMXStackFramePrinter &);
+  AMXStackFramePrinter &operator=(const AMXStackFramePrinter &);
+
+ private:
+  std::unique_ptr<StreamFormatBuffer> stream_buffer_;
+  FormatBuffer &buffer_;
   const AMXDebugInfo &debug_info_;
+  std::vector<AMXDebugSymbol> args_;
+  int depth_;
 };
 
 #endif // !AMXSTACKTRACE_H
@@ -0,0 +1,134 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "amxstatetable.h"
+
+namespace {
+
+struct CaseRecord {
+  cell value;
+  cell address;
+};
+
+bool IsCodeAddress(AMXRef amx, cell address) {
+  const AMX_HEADER *hdr = amx.GetHeader();
+  return address >= 0 && address < hdr->dat - hdr->cod;
+}
+
+bool CompareAddress(cell address,
+                    const AMXStateTable::Implementation &impl) {
+  return address < impl.address;
+}
+
+} // anonymous namespace
+
+AMXStateTable::AMXStateTable(AMXRef amx, cell function_address) {
+  // The state switch code is LOAD.pri <state var>; SWITCH <table>; the table
+  // starts with a CASETBL opcode followed by the number of records and the
+  // default address, then the (state ID, address) records.
+  cell table_address = function_address + 4 * sizeof(cell);
+  if (!IsCodeAddress(amx, table_address)) {
+    return;
+  }
+
+  const CaseRecord *table = reinterpret_cast<const CaseRecord*>(
+    amx.GetCode() + table_address + sizeof(cell));
+  cell num_records = table[0].value;
+  cell code_size = amx.GetHeader()->dat - amx.GetHeader()->cod;
+  cell table_size = (num_records + 1) * sizeof(CaseRecord);
+  if (num_records < 0 ||
+      table_address + static_cast<cell>(sizeof(cell)) + table_size
+        > code_size) {
+    return;
+  }
+
+  for (cell i = 0; i <= num_records; i++) {
+    cell address = table[i].address - reinterpret_cast<cell>(amx.GetCode());
+    // The default record has no state ID of its own; report it as 0.
+    cell state_id = (i > 0) ? table[i].value : 0;
+
+    std::vector<Implementation>::iterator iterator =
+      std::find_if(implementations_.begin(), implementations_.end(),
+                   [address](const Implementation &impl) {
+                     return impl.address == address;
+                   });
+    if (iterator == implementations_.end()) {
+      Implementation impl;
+      impl.address = address;
+      implementations_.push_back(impl);
+      iterator = implementations_.end() - 1;
+    }
+    iterator->state_ids.push_back(state_id);
+  }
+
+  std::sort(implementations_.begin(), implementations_.end(),
+            [](const Implementation &a, const Implementation &b) {
+              return a.address < b.address;
+            });
+}
+
+const AMXStateTable::Implementation *AMXStateTable::FindImplementation(
+    cell address) const {
+  std::vector<Implementation>::const_iterator iterator =
+    std::upper_bound(implementations_.begin(),
+                     implementations_.end(),
+                     address,
+                     CompareAddress);
+  if (iterator == implementations_.begin()) {
+    return nullptr;
+  }
+  return &*(iterator - 1);
+}
+
+AMXStateTables::AMXStateTables(AMX *amx)
+  : AMXHandler<AMXStateTables>(amx) {
+}
+
+// static
+std::shared_ptr<const AMXStateTable> AMXStateTables::GetTable(
+    AMXRef amx,
+    cell function_address) {
+  AMXStateTables *tables = GetHandler(amx.amx());
+  if (tables != nullptr) {
+    return tables->GetCachedTable(function_address);
+  }
+  return std::make_shared<AMXStateTable>(amx, function_address);
+}
+
+std::shared_ptr<const AMXStateTable> AMXStateTables::GetCachedTable(
+    cell function_address) {
+  // Backtraces may be printed from several threads at once, and from signal
+  // handlers that may have interrupted this very function. Don't wait for
+  // the lock, just decode the table again if it's busy.
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return std::make_shared<AMXStateTable>(amx(), function_address);
+  }
+  std::shared_ptr<const AMXStateTable> &table = tables_[function_address];
+  if (!table) {
+    table = std::make_shared<AMXStateTable>(amx(), function_address);
+  }
+  return table;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXSTATETABLE_H
+#define AMXSTATETABLE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <amx/amx.h>
+#include "amxhandler.h"
+#include "amxref.h"
+
+// Decoded state dispatch table of a function that uses automata. Each
+// implementation of the function occupies the code from its address up to
+// the address of the next one, so the table is kept sorted by address.
+class AMXStateTable {
+ public:
+  struct Implementation {
+    cell address;
+    std::vector<cell> state_ids;
+  };
+
+  AMXStateTable(AMXRef amx, cell function_address);
+
+  bool IsEmpty() const { return implementations_.empty(); }
+
+  // Returns the implementation that contains the specified code address or
+  // nullptr if the address is before the first implementation.
+  const Implementation *FindImplementation(cell address) const;
+
+ private:
+  std::vector<Implementation> implementations_;
+};
+
+// Caches the decoded state tables of an AMX instance. Tables are decoded
+// on first use and never change afterwards. If the cache is busy, e.g. when
+// called from a signal handler, the table is decoded without caching it.
+class AMXStateTables: public AMXHandler<AMXStateTables> {
+  friend class AMXHandler<AMXStateTables>;
+
+ public:
+  // Returns the state table of the function at the specified address. The
+  // table is cached if the AMX has a handler and is decoded every time
+  // otherwise.
+  static std::shared_ptr<const AMXStateTable> GetTable(AMXRef amx,
+                                                       cell function_address);
+
+ private:
+  explicit AMXStateTables(AMX *amx);
+
+  std::shared_ptr<const AMXStateTable> GetCachedTable(cell function_address);
+
+ private:
+  std::mutex mutex_;
+  std::map<cell, std::shared_ptr<const AMXStateTable>> tables_;
+};
+
+#endif // !AMXSTATETABLE_H
@@ -0,0 +1,152 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "amxcodereader.h"
+#include "amxsymbolindex.h"
+
+namespace {
+
+bool CompareAddress(cell address, const AMXSymbolIndex::Symbol &symbol) {
+  return address < symbol.start;
+}
+
+} // anonymous namespace
+
+AMXSymbolIndex::AMXSymbolIndex(AMX *amx)
+  : AMXHandler<AMXSymbolIndex>(amx) {
+}
+
+int AMXSymbolIndex::Build(const std::string &map_path) {
+  AMXRef amx(this->amx());
+  AMXCodeReader reader(amx);
+  AMXInstruction instruction;
+  cell last_return_end = 0;
+
+  symbols_.clear();
+
+  // Decoding stops at the first invalid instruction; the functions before
+  // it are still usable.
+  while (reader.address() < reader.code_size() && reader.Read(instruction)) {
+    switch (instruction.opcode) {
+      case AMX_OP_PROC: {
+        if (!symbols_.empty()) {
+          Symbol &last = symbols_.back();
+          last.end = last_return_end > last.start ? last_return_end
+                                                  : instruction.address;
+        }
+        Symbol symbol;
+        symbol.start = instruction.address;
+        symbol.end = reader.code_size();
+        symbol.is_public = false;
+        symbols_.push_back(symbol);
+        break;
+      }
+      case AMX_OP_RET:
+      case AMX_OP_RETN:
+        last_return_end = instruction.address + instruction.size;
+        break;
+      default:
+        break;
+    }
+  }
+  if (!symbols_.empty() && last_return_end > symbols_.back().start) {
+    symbols_.back().end = last_return_end;
+  }
+
+  if (Symbol *symbol = FindSymbolAt(amx.GetHeader()->cip)) {
+    symbol->name = "main";
+  }
+  for (int i = 0; i < amx.GetNumPublics(); i++) {
+    if (Symbol *symbol = FindSymbolAt(amx.GetPublicAddress(i))) {
+      symbol->name = amx.GetPublicName(i);
+      symbol->is_public = true;
+    }
+  }
+
+  return LoadMapFile(map_path);
+}
+
+int AMXSymbolIndex::LoadMapFile(const std::string &path) {
+  std::ifstream file(path.c_str());
+  if (!file.is_open()) {
+    return 0;
+  }
+
+  int num_names = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string address;
+    std::string name;
+    if (!(stream >> address >> name) || address[0] == '#') {
+      continue;
+    }
+    char *end;
+    cell start = static_cast<cell>(std::strtol(address.c_str(), &end, 0));
+    if (*end != '\0') {
+      continue;
+    }
+    // Public names come from the AMX itself and take precedence.
+    Symbol *symbol = FindSymbolAt(start);
+    if (symbol != nullptr && !symbol->is_public) {
+      symbol->name = name;
+      num_names++;
+    }
+  }
+  return num_names;
+}
+
+AMXSymbolIndex::Symbol *AMXSymbolIndex::FindSymbolAt(cell start) {
+  std::vector<Symbol>::iterator iterator =
+    std::upper_bound(symbols_.begin(), symbols_.end(), start, CompareAddress);
+  if (iterator == symbols_.begin() || (iterator - 1)->start != start) {
+    return nullptr;
+  }
+  return &*(iterator - 1);
+}
+
+const AMXSymbolIndex::Symbol *AMXSymbolIndex::FindSymbol(
+    cell address) const {
+  std::vector<Symbol>::const_iterator iterator =
+    std::upper_bound(symbols_.begin(), symbols_.end(), address,
+                     CompareAddress);
+  if (iterator == symbols_.begin() || address >= (iterator - 1)->end) {
+    return nullptr;
+  }
+  return &*(iterator - 1);
+}
+
+// static
+const AMXSymbolIndex::Symbol *AMXSymbolIndex::Lookup(AMXRef amx,
+                                                     cell address) {
+  AMXSymbolIndex *index = GetHandler(amx.amx());
+  if (index != nullptr) {
+    return index->FindSymbol(address);
+  }
+  return nullptr;
+}
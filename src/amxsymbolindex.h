@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXSYMBOLINDEX_H
+#define AMXSYMBOLINDEX_H
+
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+#include "amxhandler.h"
+#include "amxref.h"
+
+// Function symbols of a script compiled without debug info. Function
+// boundaries are recovered from the code (each function starts with PROC
+// and ends after its last RET or RETN) and named after publics and, if
+// present, entries of an external map file.
+//
+// The map file is a text file with one "<address> <name>" pair per line,
+// where address is the code address of the function (decimal or hex with a
+// 0x prefix). Empty lines and lines starting with # are ignored.
+class AMXSymbolIndex: public AMXHandler<AMXSymbolIndex> {
+  friend class AMXHandler<AMXSymbolIndex>;
+
+ public:
+  struct Symbol {
+    cell start;
+    cell end;
+    std::string name; // empty if unknown
+    bool is_public;
+  };
+
+  // Builds the index. The map file is optional. Returns the number of names
+  // read from the map file.
+  int Build(const std::string &map_path);
+
+  bool IsEmpty() const { return symbols_.empty(); }
+
+  // Returns the function that contains the specified code address or
+  // nullptr if the address is outside of any known function.
+  const Symbol *FindSymbol(cell address) const;
+
+  // Same as above but for the index of the specified AMX, if it has one.
+  static const Symbol *Lookup(AMXRef amx, cell address);
+
+ private:
+  explicit AMXSymbolIndex(AMX *amx);
+
+  Symbol *FindSymbolAt(cell start);
+  int LoadMapFile(const std::string &path);
+
+ private:
+  std::vector<Symbol> symbols_;
+};
+
+#endif // !AMXSYMBOLINDEX_H
@@ -0,0 +1,123 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "amxwatchpoints.h"
+
+AMXWatchpoints::AMXWatchpoints() {
+  watch_.lower = 0;
+  watch_.upper = 0;
+  watch_.callback = nullptr;
+}
+
+bool AMXWatchpoints::Add(AMXRef amx,
+                         cell address,
+                         cell num_cells,
+                         const std::string &name) {
+  // Only global data can be watched: stores to the heap and the stack
+  // (STOR.S, SREF.S, PUSH, etc.) don't go through the watch checks.
+  if (address < 0
+      || num_cells <= 0
+      || address % sizeof(cell) != 0
+      || address + num_cells * static_cast<cell>(sizeof(cell))
+         > amx.GetHlw()) {
+    return false;
+  }
+
+  Remove(address);
+
+  Watchpoint watchpoint;
+  watchpoint.name = name;
+  watchpoint.address = address;
+
+  cell *data = reinterpret_cast<cell*>(amx.GetData() + address);
+  watchpoint.values.assign(data, data + num_cells);
+
+  watchpoints_.push_back(watchpoint);
+  UpdateBounds();
+  return true;
+}
+
+bool AMXWatchpoints::Remove(cell address) {
+  for (std::vector<Watchpoint>::iterator it = watchpoints_.begin();
+       it != watchpoints_.end(); it++) {
+    if (it->address == address) {
+      watchpoints_.erase(it);
+      UpdateBounds();
+      return true;
+    }
+  }
+  return false;
+}
+
+void AMXWatchpoints::Clear() {
+  watchpoints_.clear();
+  UpdateBounds();
+}
+
+std::vector<AMXWatchpoints::Change> AMXWatchpoints::Check(AMXRef amx,
+                                                          cell address,
+                                                          cell size) {
+  std::vector<Change> changes;
+
+  for (std::vector<Watchpoint>::iterator it = watchpoints_.begin();
+       it != watchpoints_.end(); it++) {
+    Watchpoint &watchpoint = *it;
+    cell num_cells = static_cast<cell>(watchpoint.values.size());
+    cell end = watchpoint.address + num_cells * sizeof(cell);
+    if (size != 0 && (address >= end || address + size <= watchpoint.address)) {
+      continue;
+    }
+
+    cell *data = reinterpret_cast<cell*>(amx.GetData() + watchpoint.address);
+    for (cell i = 0; i < num_cells; i++) {
+      if (data[i] != watchpoint.values[i]) {
+        Change change = {&watchpoint, i, watchpoint.values[i], data[i]};
+        changes.push_back(change);
+        watchpoint.values[i] = data[i];
+      }
+    }
+  }
+
+  return changes;
+}
+
+void AMXWatchpoints::UpdateBounds() {
+  if (watchpoints_.empty()) {
+    watch_.lower = 0;
+    watch_.upper = 0;
+    return;
+  }
+
+  watch_.lower = watchpoints_.front().address;
+  watch_.upper = watchpoints_.front().address;
+
+  for (std::vector<Watchpoint>::const_iterator it = watchpoints_.begin();
+       it != watchpoints_.end(); it++) {
+    cell end = it->address
+      + static_cast<cell>(it->values.size() * sizeof(cell));
+    watch_.lower = std::min(watch_.lower, it->address);
+    watch_.upper = std::max(watch_.upper, end);
+  }
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef AMXWATCHPOINTS_H
+#define AMXWATCHPOINTS_H
+
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+#include "amxref.h"
+
+// A list of data watchpoints of an AMX instance. The interpreter only checks
+// the bounds stored in watch() and calls back into the host, which then uses
+// Check() to find out which of the watched cells have actually changed.
+class AMXWatchpoints {
+ public:
+  struct Watchpoint {
+    std::string name;
+    cell address;
+    std::vector<cell> values;
+  };
+
+  struct Change {
+    const Watchpoint *watchpoint;
+    cell index;
+    cell old_value;
+    cell new_value;
+  };
+
+  AMXWatchpoints();
+
+  AMX_WATCH *watch() { return &watch_; }
+
+  bool IsEmpty() const { return watchpoints_.empty(); }
+
+  // Watches num_cells cells starting at the specified data address. Returns
+  // false if the address range is outside of the global data (the heap and
+  // the stack can't be watched).
+  bool Add(AMXRef amx,
+           cell address,
+           cell num_cells,
+           const std::string &name);
+  bool Remove(cell address);
+  void Clear();
+
+  // Compares the watched cells that overlap [address, address + size) with
+  // their previously seen values. A size of 0 means that all cells should
+  // be checked.
+  std::vector<Change> Check(AMXRef amx, cell address, cell size);
+
+ private:
+  AMXWatchpoints(const AMXWatchpoints &);
+  AMXWatchpoints &operator=(const AMXWatchpoints &);
+
+  void UpdateBounds();
+
+ private:
+  std::vector<Watchpoint> watchpoints_;
+  AMX_WATCH watch_;
+};
+
+#endif // !AMXWATCHPOINTS_H
@@ -22,29 +22,50 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
 #include <functional>
 #include <iomanip>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <amx/amxaux.h>
+#include "amxcallgraph.h"
 #include "amxcallstack.h"
 #include "amxdebuginfo.h"
+#include "amxdebuginfoprefetcher.h"
+#include "amxexechistory.h"
 #include "amxopcode.h"
 #include "amxpathfinder.h"
+#include "amxrecording.h"
 #include "amxref.h"
+#include "amxstackanalyzer.h"
 #include "amxstacktrace.h"
+#include "amxsymbolindex.h"
+#include "amxwatchpoints.h"
 #include "crashdetect.h"
+#include "debugger.h"
 #include "fileutils.h"
+#include "formatbuffer.h"
 #include "log.h"
+#include "longcallprofile.h"
 #include "options.h"
 #include "os.h"
+#include "probes.h"
 #include "stacktrace.h"
 #include "stringutils.h"
+#include "tickprofiler.h"
+#include "watchdog.h"
 
 #define AMX_EXEC_GDK    (-10)
 #define AMX_EXEC_GDK_42 (-10000)
@@ -69,20 +90,219 @@ void PrintStream(Printer printer, const std::stringstream &stream) {
                            PrintLine<Printer>(printer));
 }
 
+// Sends each line to the debug log as soon as it is complete, so that long
+// output (e.g. deep backtraces) doesn't have to be built up in memory.
+class LogFormatBuffer: public FormatBuffer {
+ public:
+  LogFormatBuffer() : FormatBuffer(storage_, sizeof(storage_)) {}
+  ~LogFormatBuffer() {
+    if (!IsEmpty()) {
+      AppendNewLine();
+    }
+  }
+
+  void AppendNewLine() {
+    LogDebugPrint("%s", c_str());
+    Clear();
+  }
+
+ private:
+  char storage_[1024];
+};
+
+// Recursion is only summarized when the same frames repeat at least this
+// many times in a row.
+const std::size_t kMinFrameRepeats = 4;
+const std::size_t kMaxRecursionPeriod = 8;
+
+// How many times to try to lock the list of threads or to copy another
+// thread's call stack before giving up on it.
+const int kMaxLockAttempts = 1000;
+
+bool IsSameFrame(const AMXStackFrame &a, const AMXStackFrame &b) {
+  return a.return_address() == b.return_address()
+      && a.caller_address() == b.caller_address();
+}
+
+// Looks for a block of up to kMaxRecursionPeriod frames starting at index
+// that is immediately repeated (as in direct or mutual recursion). Returns
+// the number of consecutive occurrences of the block and its length.
+std::size_t FindRepeatedFrames(const std::deque<AMXStackFrame> &frames,
+                               std::size_t index,
+                               std::size_t &period) {
+  for (period = 1; period <= kMaxRecursionPeriod; period++) {
+    std::size_t end = index + period;
+    while (end + period <= frames.size()
+           && IsSameFrame(frames[end], frames[end - period])) {
+      end++;
+    }
+    std::size_t repeats = (end - index) / period;
+    if (repeats >= kMinFrameRepeats) {
+      return repeats;
+    }
+  }
+  period = 1;
+  return 1;
+}
+
+// Waits a little for a lock that another thread may hold. Gives up if it
+// can't be taken quickly: the holder may have been interrupted by the
+// signal that is being handled, or may not exist at all in a forked process.
+bool TryLockBriefly(std::unique_lock<std::mutex> &lock) {
+  for (int i = 0; i < kMaxLockAttempts; i++) {
+    if (lock.try_lock()) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+// Marks a change to the call stack of the current thread for the threads
+// that may be copying it.
+class CallStackChange {
+ public:
+  explicit CallStackChange(std::atomic<unsigned int> &seq)
+    : seq_(seq),
+      value_(seq.load(std::memory_order_relaxed))
+  {
+    seq_.store(value_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  ~CallStackChange() {
+    seq_.store(value_ + 2, std::memory_order_release);
+  }
+
+ private:
+  std::atomic<unsigned int> &seq_;
+  unsigned int value_;
+};
+
+// A call from a thread's call stack and, for publics, the stack frames of
+// the script it was executing, innermost first. The frames of a public that
+// another thread is executing right now are unknown.
+struct BacktraceCall {
+  AMXCall call;
+  std::deque<AMXStackFrame> frames;
+  bool running;
+};
+
+// Unwinds a call stack from the innermost call outwards. A native function
+// may call publics of other scripts (CallRemoteFunction) or of the same one
+// (CallLocalFunction); either way the registers saved at the native call say
+// where its script was, so unwinding continues in the calling script.
+//
+// The registers of the innermost script can only be read by the thread that
+// runs it (live_registers); other threads only see the saved ones.
+std::vector<BacktraceCall> GetAMXBacktrace(const AMXCallStack &call_stack,
+                                           bool live_registers) {
+  std::vector<BacktraceCall> backtrace;
+  if (call_stack.IsEmpty()) {
+    return backtrace;
+  }
+
+  AMXCallStack calls = call_stack;
+  AMXRef amx = calls.Top().amx();
+  cell frm = 0;
+  cell cip = 0;
+  if (live_registers) {
+    frm = amx.GetFrm();
+    cip = amx.GetCip();
+  }
+
+  while (!calls.IsEmpty()) {
+    BacktraceCall entry = {calls.Pop(), std::deque<AMXStackFrame>(), false};
+    const AMXCall &call = entry.call;
+
+    if (call.IsNative()) {
+      amx = call.amx();
+      frm = call.frm();
+      cip = call.cip();
+      backtrace.push_back(entry);
+      continue;
+    }
+
+    if (!live_registers && backtrace.empty()) {
+      entry.frames.push_back(AMXStackFrame(amx, 0, 0, 0,
+        amx.GetPublicAddress(call.index())));
+      entry.running = true;
+      backtrace.push_back(entry);
+      frm = call.frm();
+      cip = call.cip();
+      continue;
+    }
+
+    // A public that wasn't called from a native (e.g. one called by the
+    // server) can only be unwound in the script whose registers are known.
+    if (call.amx() != amx || cip == 0) {
+      break;
+    }
+
+    AMXStackTrace trace = GetAMXStackTrace(amx, frm, cip, -1);
+    while (trace.current_frame().return_address() != 0) {
+      entry.frames.push_back(trace.current_frame());
+      if (!trace.MoveNext()) {
+        break;
+      }
+    }
+
+    cell entry_point = amx.GetPublicAddress(call.index());
+    if (entry.frames.empty()) {
+      entry.frames.push_front(AMXStackFrame(amx, frm, 0, 0, entry_point));
+    } else {
+      entry.frames.back().set_caller_address(entry_point);
+    }
+    backtrace.push_back(entry);
+
+    frm = call.frm();
+    cip = call.cip();
+  }
+  return backtrace;
+}
+
 } // anonymous namespace
 
-AMXCallStack CrashDetect::call_stack_;
+thread_local CrashDetect::ThreadState CrashDetect::thread_state_;
+thread_local CrashDetect::ThreadState *CrashDetect::current_thread_state_;
+CrashDetect::ThreadState *CrashDetect::main_thread_state_ = nullptr;
+std::mutex CrashDetect::threads_mutex_;
+std::vector<CrashDetect::ThreadState*> CrashDetect::threads_;
 
 unsigned int CrashDetect::long_call_time_;
 std::chrono::microseconds CrashDetect::long_call_time_current_;
-std::chrono::high_resolution_clock::time_point CrashDetect::long_call_time_next_;
 bool CrashDetect::long_call_time_running_;
+std::atomic<bool> CrashDetect::dump_requested_(false);
+
+CrashDetect::ThreadState::ThreadState()
+  : long_call_amx(nullptr),
+    long_call_index(0),
+    long_call_budget(0),
+    long_call_time_next(std::chrono::high_resolution_clock::time_point::max()),
+    long_call_profile_next(
+      std::chrono::high_resolution_clock::time_point::max()),
+    long_call_detected(false),
+    id(std::this_thread::get_id()),
+    call_stack_seq(0)
+{
+  std::lock_guard<std::mutex> lock(threads_mutex_);
+  threads_.push_back(this);
+  current_thread_state_ = this;
+}
+
+CrashDetect::ThreadState::~ThreadState() {
+  std::lock_guard<std::mutex> lock(threads_mutex_);
+  threads_.erase(std::find(threads_.begin(), threads_.end(), this));
+  current_thread_state_ = nullptr;
+}
 
 CrashDetect::CrashDetect(AMX *amx)
   : AMXHandler<CrashDetect>(amx),
     amx_(amx),
     prev_debug_(nullptr),
     prev_callback_(nullptr),
+    ext_hooks_(),
+    exec_history_(Options::shared().exec_history()),
     last_frame_(amx->stp),
     block_exec_errors_(false),
     address_naught_(false)
@@ -92,19 +312,85 @@ CrashDetect::CrashDetect(AMX *amx)
 void CrashDetect::PluginLoad() {
   long_call_time_ = Options::shared().long_call_time();
   long_call_time_current_ = std::chrono::microseconds(long_call_time_);
-  long_call_time_next_ = std::chrono::high_resolution_clock::time_point::max();
   long_call_time_running_ = long_call_time_ != 0;
+
+  if (Options::shared().tick_budget() != 0) {
+    TickProfiler::shared().Start(
+      std::chrono::microseconds(Options::shared().tick_budget()));
+  }
+
+  // The main thread is the one that loads plugins and runs ProcessTick().
+  main_thread_state_ = &thread_state_;
+  if (Options::shared().watchdog_timeout() != 0) {
+    os::SetThreadDumpHandler(OnThreadDump);
+    Watchdog::shared().Start(
+      std::chrono::milliseconds(Options::shared().watchdog_timeout()),
+      [] {
+        if (!os::DumpMainThread()) {
+          LogDebugPrint("Server is not responding, but the main thread "
+                        "could not be interrupted");
+        }
+      });
+  }
+  if (Options::shared().dump_signal()) {
+    os::SetDumpRequestHandler(OnDumpRequest);
+  }
+
+  const std::string &debug_socket = Options::shared().debug_socket();
+  if (!debug_socket.empty()) {
+    if (Debugger::shared().Start(debug_socket)) {
+      LogDebugPrint("Debugger is listening on %s", debug_socket.c_str());
+    } else {
+      LogDebugPrint("Could not start debugger on %s", debug_socket.c_str());
+    }
+  }
 }
 
 void CrashDetect::PluginUnload() {
   long_call_time_running_ = false;
+  Debugger::shared().Stop();
+  Watchdog::shared().Stop();
+
+  if (TickProfiler::shared().IsEnabled()) {
+    std::stringstream stream;
+    TickProfiler::shared().PrintHistogram(stream);
+    PrintStream(LogDebugPrint, stream);
+  }
+}
+
+// static
+void CrashDetect::ProcessTick() {
+  Watchdog::shared().Feed();
+  CheckDumpRequest();
+
+  if (!TickProfiler::shared().IsEnabled()
+      || !TickProfiler::shared().EndTick()) {
+    return;
+  }
+
+  // An overloaded server may go over budget every tick; one report per
+  // second is enough to see where the time goes.
+  static std::time_t last_report_time = 0;
+  std::time_t now = std::time(nullptr);
+  if (now == last_report_time) {
+    return;
+  }
+  last_report_time = now;
+
+  std::stringstream stream;
+  TickProfiler::shared().PrintReport(stream);
+  PrintStream(LogDebugPrint, stream);
 }
 
 int CrashDetect::Load() {
   amx_path_ = AMXPathFinder::shared().Find(amx());
-  if (!amx_path_.empty()) {
+  if (!amx_path_.empty()
+      && !AMXDebugInfoPrefetcher::shared().Claim(amx_path_, debug_info_)) {
+    // Stripped scripts may have their debug info in a separate file.
     if (AMXDebugInfo::IsPresent(amx())) {
       debug_info_.Load(amx_path_);
+    } else {
+      debug_info_.LoadDetached(amx_path_);
     }
   }
 
@@ -114,14 +400,111 @@ int CrashDetect::Load() {
     amx_name_ = "<unknown>";
   }
 
+  // Without debug info functions can still be identified by their code;
+  // the names come from publics and <script>.map if there is one.
+  if (!debug_info_.IsLoaded()) {
+    std::string map_path;
+    if (!amx_path_.empty()) {
+      std::string extension = fileutils::GetFileExtension(amx_path_);
+      map_path = amx_path_.substr(0, amx_path_.length() - extension.length());
+      if (extension.empty()) {
+        map_path += ".";
+      }
+      map_path += "map";
+    }
+    int num_names = AMXSymbolIndex::GetHandler(amx())->Build(map_path);
+    if (num_names > 0) {
+      LogDebugPrint("Loaded %d function names from %s",
+                    num_names, map_path.c_str());
+    }
+  }
+
   amx_.SetSysreqDEnabled(false);
   prev_debug_ = amx_.GetDebugHook();
   prev_callback_ = amx_.GetCallback();
 
+  if (Options::shared().exec_history() != 0) {
+    ext_hooks_.exec_history = exec_history_.ring();
+  }
+
+  LoadLongCallBudgets();
+
+  if (Options::shared().stack_analysis()) {
+    std::stringstream stream;
+    PrintStackUsage(stream);
+    PrintStream(LogDebugPrint, stream);
+  }
+
+  const std::string &call_graph_dir = Options::shared().call_graph_dir();
+  if (!call_graph_dir.empty() && !amx_path_.empty()) {
+    WriteCallGraph(call_graph_dir);
+  }
+
+  // Variables that are not defined in this script are silently ignored as
+  // the same list applies to all scripts.
+  const std::vector<std::string> &watch = Options::shared().watch();
+  for (std::vector<std::string>::const_iterator it = watch.begin();
+       it != watch.end(); it++) {
+    WatchVariable(*it);
+  }
+
+  if (Debugger::shared().IsEnabled()) {
+    Debugger::shared().OnLoad(this);
+  }
+
+  if (TickProfiler::shared().IsEnabled()) {
+    TickProfiler::shared().AddScript(amx_, amx_name_);
+  }
+
+  const std::string &record_dir = Options::shared().record_dir();
+  if (!record_dir.empty() && !amx_path_.empty()) {
+    std::string path = record_dir + fileutils::kNativePathSepChar
+                                  + amx_name_ + ".rec";
+    if (fileutils::MakeDirectory(record_dir)
+        && recording_.Open(path, amx_)) {
+      LogDebugPrint("Recording %s to %s", amx_name_.c_str(), path.c_str());
+    } else {
+      LogDebugPrint("Could not open %s for recording", path.c_str());
+    }
+  }
+
   return AMX_ERR_NONE;
 }
 
 int CrashDetect::Unload() {
+  recording_.Close();
+
+  if (TickProfiler::shared().IsEnabled()) {
+    TickProfiler::shared().RemoveScript(amx_);
+  }
+
+  if (!heap_profiler_.IsEmpty()) {
+    std::stringstream stream;
+    PrintHeapProfile(stream);
+    PrintStream(LogDebugPrint, stream);
+  }
+
+  if (ext_hooks_.meter != nullptr) {
+    std::stringstream stream;
+    PrintInstructionCounts(stream);
+    PrintStream(LogDebugPrint, stream);
+
+    const std::string &report_dir = Options::shared().instruction_report_dir();
+    if (!report_dir.empty() && !amx_path_.empty()) {
+      std::string path = report_dir + fileutils::kNativePathSepChar
+                                    + amx_name_ + ".insns";
+      std::ofstream report;
+      if (fileutils::MakeDirectory(report_dir)) {
+        report.open(path.c_str());
+      }
+      if (report.is_open()) {
+        WriteInstructionReport(report);
+      } else {
+        LogDebugPrint("Could not write instruction report to %s",
+                      path.c_str());
+      }
+    }
+  }
   return AMX_ERR_NONE;
 }
 
@@ -139,6 +522,24 @@ int CrashDetect::OnDebugHook() {
     }
   }
   last_frame_ = amx_.GetFrm();
+
+  if (!breakpoints_.empty() || Debugger::IsStepping()) {
+    const char *reason = nullptr;
+    if (breakpoints_.count(amx_.GetCip()) != 0) {
+      reason = "breakpoint";
+    } else if (Debugger::shared().ShouldStep(amx_, amx_.GetFrm())) {
+      reason = "step";
+    }
+    if (reason != nullptr) {
+      // Neither a breakpoint is a hang, nor does the time spent in the
+      // debugger count towards the call time.
+      Watchdog::shared().Pause();
+      Debugger::shared().Break(this, reason);
+      Watchdog::shared().Resume();
+      LongCallOption(AMX_LCT_OPTION_RESTART);
+    }
+  }
+
   return prev_debug_ != nullptr ? prev_debug_(amx_) : AMX_ERR_NONE;
 }
 
@@ -155,13 +556,27 @@ int CrashDetect::OnCallback(cell index, cell *result, cell *params) {
     }
   }
 
+  if (recording_.IsOpen()) {
+    recording_.BeginNativeCall(amx_, index, params);
+  }
+
+  CRASHDETECT_PROBE3(native_entry, amx(), index, amx_.GetCip());
   int error = prev_callback_(amx_, index, result, params);
+  CRASHDETECT_PROBE4(native_return, amx(), index, amx_.GetCip(), error);
+
+  if (recording_.IsOpen()) {
+    recording_.WriteNativeReturn(amx_, index, error, *result);
+  }
 
   Pop();
   return error;
 }
 
 int CrashDetect::OnExec(cell *retval, int index) {
+  if (call_stack().IsEmpty() && Debugger::shared().IsEnabled()) {
+    Debugger::shared().Poll();
+  }
+
   Push(AMXCall::Public(amx_, index));
 
   if (Options::shared().trace_flags() & TRACE_FUNCTIONS) {
@@ -190,7 +605,37 @@ int CrashDetect::OnExec(cell *retval, int index) {
     }
   }
 
+  bool record = recording_.IsOpen() && index != AMX_EXEC_CONT;
+  if (record) {
+    recording_.WritePublicCall(amx_, index);
+  }
+
+  bool count_instructions = ext_hooks_.meter != nullptr;
+  if (count_instructions) {
+    instruction_meter_.BeginPublic(index);
+  }
+
+  bool profile_tick = TickProfiler::shared().IsEnabled()
+                      && TickProfiler::shared().BeginPublic(amx_, index);
+
+  CRASHDETECT_PROBE3(public_entry, amx(), index, amx_.GetCip());
   int error = ::amx_Exec(amx_, retval, index);
+  CRASHDETECT_PROBE4(public_return, amx(), index, amx_.GetCip(), error);
+
+  if (profile_tick) {
+    TickProfiler::shared().EndPublic();
+  }
+
+  if (count_instructions) {
+    instruction_meter_.EndPublic();
+  }
+
+  if (record) {
+    recording_.WritePublicReturn(index,
+                                 error,
+                                 retval != nullptr ? *retval : 0);
+  }
+
   if (error == AMX_ERR_CALLBACK
       || error == AMX_ERR_NOTFOUND
       || error == AMX_ERR_INIT
@@ -202,6 +647,10 @@ int CrashDetect::OnExec(cell *retval, int index) {
   }
 
   Pop();
+
+  if (record && call_stack().IsEmpty()) {
+    recording_.Flush();
+  }
   return error;
 }
 
@@ -221,6 +670,8 @@ int CrashDetect::OnExecError(int index, cell *retval, int error) {
     return AMX_ERR_NONE;
   }
 
+  CRASHDETECT_PROBE4(exec_error, amx(), index, amx_.GetCip(), error);
+
   // For compatibility with sampgdk.
   if (error == AMX_ERR_INDEX && (index == AMX_EXEC_GDK ||
                                  index <= AMX_EXEC_GDK_42)) {
@@ -240,6 +691,19 @@ int CrashDetect::OnExecError(int index, cell *retval, int error) {
   std::stringstream bt_stream;
   PrintAMXBacktrace(bt_stream);
 
+  // Same goes for the execution history: OnRuntimeError would push its own
+  // jumps and calls on top of the ones that led to the error.
+  std::stringstream history_stream;
+  if (ext_hooks_.exec_history != nullptr) {
+    PrintExecHistory(history_stream);
+  }
+
+  if (Options::shared().snapshot_flags() & SNAPSHOT_ON_ERROR) {
+    std::stringstream reason;
+    reason << "run time error " << error;
+    TakeSnapshot(reason.str());
+  }
+
   // Remember values of AMX registers before calling OnRuntimeError().
   AMX amx_state = *amx_.amx();
 
@@ -265,6 +729,7 @@ int CrashDetect::OnExecError(int index, cell *retval, int error) {
         && error != AMX_ERR_CALLBACK
         && error != AMX_ERR_INIT) {
       PrintStream(LogDebugPrint, bt_stream);
+      PrintStream(LogDebugPrint, history_stream);
     }
   }
 
@@ -302,11 +767,338 @@ int CrashDetect::OnAddressNaughtRequest(int option) {
   return AMX_ERR_NONE;
 }
 
+int CrashDetect::OnWatch(cell address, cell size) {
+  std::vector<AMXWatchpoints::Change> changes =
+    watchpoints_.Check(amx_, address, size);
+  if (changes.empty()) {
+    return AMX_ERR_NONE;
+  }
+
+  // A size of 0 means that the write was done by a native function, in which
+  // case CIP points to the instruction following SYSREQ.C.
+  const char *native = nullptr;
+  if (size == 0) {
+    cell *ip = reinterpret_cast<cell*>(amx_.GetCode() + amx_.GetCip());
+    if (*(ip - 2) == RelocateAMXOpcode(AMX_OP_SYSREQ_C)) {
+      native = amx_.GetNativeName(*(ip - 1));
+    }
+  }
+
+  for (std::vector<AMXWatchpoints::Change>::const_iterator it =
+         changes.begin(); it != changes.end(); it++) {
+    const AMXWatchpoints::Change &change = *it;
+    std::stringstream stream;
+    stream << "Watchpoint " << change.watchpoint->name;
+    if (change.watchpoint->values.size() > 1) {
+      stream << "[" << change.index << "]";
+    }
+    stream << " changed from " << change.old_value
+           << " to " << change.new_value;
+    if (native != nullptr) {
+      stream << " in native " << native;
+    }
+    PrintStream(LogDebugPrint, stream);
+  }
+  PrintAMXBacktrace();
+
+  return AMX_ERR_NONE;
+}
+
+int CrashDetect::OnHeapChange(cell cip, cell from, cell to) {
+  // Allocations made by the host or by another script, e.g. for arguments
+  // of CallRemoteFunction(), happen while CIP still holds whatever this
+  // script left there.
+  cell site = AMXHeapProfiler::kHostSite;
+  if (!call_stack().IsEmpty() && call_stack().Top().amx() == amx_) {
+    if (!call_stack().Top().IsNative()) {
+      site = cip;
+    } else if (cip >= static_cast<cell>(2 * sizeof(cell))) {
+      // Allocated by a native function: CIP points past its SYSREQ.C, make
+      // it point to the SYSREQ.C itself.
+      site = cip;
+      cell *ip = reinterpret_cast<cell*>(amx_.GetCode() + cip);
+      if (*(ip - 2) == RelocateAMXOpcode(AMX_OP_SYSREQ_C)) {
+        site = cip - 2 * sizeof(cell);
+      }
+    }
+  }
+  heap_profiler_.OnHeapChange(site, from, to);
+  return AMX_ERR_NONE;
+}
+
+int CrashDetect::OnMeterEvent(int event, cell cip) {
+  if (event == AMX_METER_ENTER) {
+    instruction_meter_.OnEnter(cip);
+  } else {
+    instruction_meter_.OnLeave();
+  }
+  return AMX_ERR_NONE;
+}
+
+bool CrashDetect::WatchVariable(const std::string &name) {
+  if (!debug_info_.IsLoaded()) {
+    return false;
+  }
+
+  AMXDebugSymbol symbol = debug_info_.GetStaticVariable(name);
+  if (!symbol) {
+    return false;
+  }
+
+  // Multi-dimensional arrays are preceded by their indirection tables, i.e.
+  // new a[2][3] occupies 2 + 2 * 3 cells.
+  cell num_cells = 1;
+  if (symbol.IsArray()) {
+    std::vector<AMXDebugSymbolDim> dims = symbol.GetDims();
+    cell dim_cells = 1;
+    num_cells = 0;
+    for (std::vector<AMXDebugSymbolDim>::const_iterator it = dims.begin();
+         it != dims.end(); it++) {
+      dim_cells *= it->GetSize();
+      num_cells += dim_cells;
+    }
+  }
+
+  bool result = watchpoints_.Add(amx_, symbol.GetAddress(), num_cells, name);
+  UpdateWatchpoints();
+  return result;
+}
+
+bool CrashDetect::WatchAddress(cell address, cell num_cells) {
+  std::stringstream name;
+  name << "0x" << std::hex << std::uppercase << std::setw(8)
+       << std::setfill('0') << address;
+  bool result = watchpoints_.Add(amx_, address, num_cells, name.str());
+  if (!result) {
+    LogDebugPrint("Could not watch %s: only global data can be watched",
+                  name.str().c_str());
+  }
+  UpdateWatchpoints();
+  return result;
+}
+
+bool CrashDetect::UnwatchVariable(const std::string &name) {
+  if (!debug_info_.IsLoaded()) {
+    return false;
+  }
+
+  AMXDebugSymbol symbol = debug_info_.GetStaticVariable(name);
+  if (!symbol) {
+    return false;
+  }
+
+  return UnwatchAddress(symbol.GetAddress());
+}
+
+bool CrashDetect::UnwatchAddress(cell address) {
+  bool result = watchpoints_.Remove(address);
+  UpdateWatchpoints();
+  return result;
+}
+
+int CrashDetect::SetLongCallBudget(const std::string &pattern,
+                                   long long time) {
+  int count = 0;
+  for (cell index = AMX_EXEC_MAIN; index < amx_.GetNumPublics(); index++) {
+    const char *name = index == AMX_EXEC_MAIN
+      ? "main"
+      : amx_.GetPublicName(index);
+    if (name != nullptr && stringutils::MatchWildcard(pattern.c_str(), name)) {
+      long_call_budgets_[index + 2] =
+        std::chrono::microseconds(time < 0 ? -1 : time);
+      count++;
+    }
+  }
+  return count;
+}
+
+long long CrashDetect::GetLongCallBudget(const std::string &name) const {
+  cell index = AMX_EXEC_MAIN;
+  if (name != "main") {
+    index = amx_.GetPublicIndex(name.c_str());
+    if (index < 0) {
+      return -1;
+    }
+  }
+  return long_call_budgets_[index + 2].count();
+}
+
+void CrashDetect::LoadLongCallBudgets() {
+  long_call_budgets_.assign(amx_.GetNumPublics() + 2,
+                            std::chrono::microseconds(-1));
+
+  // Go through the patterns in reverse order so that the first matching
+  // pattern wins.
+  const std::vector<LongCallBudget> &budgets =
+    Options::shared().long_call_budgets();
+  for (std::vector<LongCallBudget>::const_reverse_iterator it =
+         budgets.rbegin(); it != budgets.rend(); it++) {
+    if (stringutils::MatchWildcard(it->script.c_str(), amx_name_.c_str())) {
+      SetLongCallBudget(it->function, it->time);
+    }
+  }
+}
+
+long long CrashDetect::GetInstructionCount() const {
+  if (ext_hooks_.meter == nullptr) {
+    return -1;
+  }
+  return static_cast<long long>(instruction_meter_.total());
+}
+
+long long CrashDetect::GetPublicInstructionCount(
+    const std::string &name) const {
+  cell index = AMX_EXEC_MAIN;
+  if (name != "main") {
+    index = amx_.GetPublicIndex(name.c_str());
+    if (index < 0) {
+      return -1;
+    }
+  }
+  const AMXInstructionMeter::Counter *counter =
+    instruction_meter_.GetPublicCounter(index);
+  return counter != nullptr ? counter->instructions : -1;
+}
+
+long long CrashDetect::GetFunctionInstructionCount(
+    const std::string &name) const {
+  if (!debug_info_.IsLoaded()) {
+    return -1;
+  }
+
+  // Functions with states have one symbol per implementation.
+  long long count = -1;
+  AMXDebugInfo::SymbolTable symbols = debug_info_.GetSymbols();
+  for (AMXDebugInfo::SymbolTable::const_iterator it = symbols.begin();
+       it != symbols.end(); ++it) {
+    if (it->IsFunction() && name == it->GetNamePtr()) {
+      const AMXInstructionMeter::Counter *counter =
+        instruction_meter_.GetFunctionCounter(it->GetCodeStart());
+      if (counter != nullptr) {
+        count = std::max(count, 0LL) + counter->instructions;
+      }
+    }
+  }
+  return count;
+}
+
+int CrashDetect::BenchmarkPublic(const std::string &name,
+                                 int iterations,
+                                 BenchmarkResult &result) {
+  cell index = amx_.GetPublicIndex(name.c_str());
+  if (index < 0) {
+    return AMX_ERR_NOTFOUND;
+  }
+  if (iterations <= 0) {
+    return AMX_ERR_DOMAIN;
+  }
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Estimate the cost of reading the clock so that it can be subtracted
+  // from each sample.
+  Clock::duration clock_overhead = Clock::duration::max();
+  for (int i = 0; i < 100; i++) {
+    Clock::time_point start = Clock::now();
+    clock_overhead = std::min(clock_overhead, Clock::now() - start);
+  }
+
+  // Measure only the script's own code: run without the debug hook and
+  // without any of the optional instrumentation (history, watchpoints,
+  // profilers). Run time errors are still reported.
+  AMX_EXT_HOOKS hooks = AMX_EXT_HOOKS();
+  hooks.exec_error = ext_hooks_.exec_error;
+  hooks.long_call_ctl = ext_hooks_.long_call_ctl;
+  hooks.address_naught_ctl = ext_hooks_.address_naught_ctl;
+  AMX_DEBUG debug_hook = amx_.GetDebugHook();
+  amx_.SetDebugHook(prev_debug_);
+  amx_SetExtHooks(amx_, &hooks);
+
+  int num_warmup_iterations = iterations / 10 + 1;
+  std::vector<long long> samples;
+  samples.reserve(iterations);
+
+  // Suspend the long call timer of the calling public while the benchmark
+  // runs, it would otherwise go off after the first few iterations.
+  typedef std::chrono::high_resolution_clock LongCallClock;
+  ThreadState &state = thread_state_;
+  LongCallClock::time_point time_next = state.long_call_time_next;
+  LongCallClock::time_point profile_next = state.long_call_profile_next;
+  LongCallClock::time_point suspend_time = LongCallClock::now();
+  state.long_call_time_next = LongCallClock::time_point::max();
+  state.long_call_profile_next = LongCallClock::time_point::max();
+
+  int error = AMX_ERR_NONE;
+  for (int i = 0; i < num_warmup_iterations + iterations; i++) {
+    cell retval;
+    Push(AMXCall::Public(amx_, index));
+    Clock::time_point start = Clock::now();
+    error = ::amx_Exec(amx_, &retval, index);
+    Clock::duration elapsed = Clock::now() - start - clock_overhead;
+    Pop();
+    if (error != AMX_ERR_NONE) {
+      break;
+    }
+    if (i >= num_warmup_iterations) {
+      samples.push_back(std::max(0LL, static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+          .count())));
+    }
+  }
+
+  amx_SetExtHooks(amx_, &ext_hooks_);
+  amx_.SetDebugHook(debug_hook);
+
+  // Don't count the benchmark towards the time of the calling public.
+  LongCallClock::duration suspended = LongCallClock::now() - suspend_time;
+  if (time_next != LongCallClock::time_point::max()) {
+    state.long_call_time_next = time_next + suspended;
+  }
+  if (profile_next != LongCallClock::time_point::max()) {
+    state.long_call_profile_next = profile_next + suspended;
+  }
+
+  if (error != AMX_ERR_NONE) {
+    return error;
+  }
+
+  // Reject samples above the outer Tukey fence (e.g. interrupted by the OS).
+  std::sort(samples.begin(), samples.end());
+  std::size_t n = samples.size();
+  long long q1 = samples[n / 4];
+  long long q3 = samples[n * 3 / 4];
+  long long fence = q3 + 3 * (q3 - q1);
+  samples.erase(std::upper_bound(samples.begin(), samples.end(), fence),
+                samples.end());
+
+  n = samples.size();
+  long long sum = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    sum += samples[i];
+  }
+  result.num_samples = static_cast<int>(n);
+  result.num_outliers = iterations - static_cast<int>(n);
+  result.min = samples[0];
+  result.median = samples[(n - 1) / 2];
+  result.p99 = samples[(n * 99 + 99) / 100 - 1];
+  result.mean = sum / static_cast<long long>(n);
+  return AMX_ERR_NONE;
+}
+
+void CrashDetect::UpdateWatchpoints() {
+  // The interpreter only looks at the watch bounds when this is set, so
+  // scripts without watchpoints don't pay for them.
+  ext_hooks_.watch = watchpoints_.IsEmpty() ? nullptr : watchpoints_.watch();
+}
+
 // static
 void CrashDetect::OnCrash(const os::Context &context) {
+  // Signal handlers must not create the thread's state, so use it only if
+  // it already exists.
+  const ThreadState *state = current_thread_state_;
   CrashDetect *instance = nullptr;
-  if (!call_stack_.IsEmpty()) {
-    instance = GetHandler(call_stack_.Top().amx());
+  if (state != nullptr && !state->call_stack.IsEmpty()) {
+    instance = GetHandler(state->call_stack.Top().amx());
   }
   if (instance != nullptr) {
     LogDebugPrint("Server crashed while executing %s",\
@@ -323,9 +1115,10 @@ void CrashDetect::OnCrash(const os::Context &context) {
 
 // static
 void CrashDetect::OnInterrupt(const os::Context &context) {
+  const ThreadState *state = current_thread_state_;
   CrashDetect *instance = nullptr;
-  if (!call_stack_.IsEmpty()) {
-    instance = GetHandler(call_stack_.Top().amx());
+  if (state != nullptr && !state->call_stack.IsEmpty()) {
+    instance = GetHandler(state->call_stack.Top().amx());
   }
   if (instance != nullptr) {
     LogDebugPrint("Server received interrupt signal while executing %s",
@@ -335,17 +1128,53 @@ void CrashDetect::OnInterrupt(const os::Context &context) {
   }
   PrintAMXBacktrace();
   PrintNativeBacktrace(context.native_context());
+
+  std::stringstream threads_stream;
+  PrintOtherThreadsAMXBacktraces(threads_stream);
+  PrintStream(LogDebugPrint, threads_stream);
+}
+
+// static
+void CrashDetect::OnThreadDump(const os::Context &context,
+                               void *const *stack,
+                               int stack_size) {
+  // Runs in the watchdog thread after the main thread has been let go.
+  LogDebugPrint("Server has not responded for %u ms (hang in a native "
+                "function?)", Options::shared().watchdog_timeout());
+
+  std::stringstream stream;
+  if (main_thread_state_ != nullptr) {
+    PrintThreadAMXBacktrace(stream, *main_thread_state_);
+  }
+  PrintStream(LogDebugPrint, stream);
+
+  std::vector<StackFrame> frames;
+  if (stack != nullptr) {
+    GetStackTrace(frames, stack, stack_size);
+  } else {
+    GetStackTrace(frames, context.native_context());
+  }
+  std::stringstream native_stream;
+  PrintNativeBacktrace(native_stream, frames);
+  PrintStream(LogDebugPrint, native_stream);
+}
+
+// static
+void CrashDetect::OnDumpRequest() {
+  // Called from a signal handler: only lock-free atomics are safe here.
+  dump_requested_.store(true, std::memory_order_relaxed);
 }
 
 // static
 void CrashDetect::PrintTraceFrame(const AMXStackFrame &frame,
                                   const AMXDebugInfo &debug_info) {
-  std::stringstream stream;
-  AMXStackFramePrinter printer(stream, debug_info);
+  char storage[1024];
+  FormatBuffer buffer(storage, sizeof(storage));
+  AMXStackFramePrinter printer(buffer, debug_info);
   printer.PrintCallerNameAndArguments(frame);
   if (Options::shared().trace_filter() == nullptr
-      || Options::shared().trace_filter()->Test(stream.str())) {
-    PrintStream(LogTracePrint, stream);
+      || Options::shared().trace_filter()->Test(buffer.c_str())) {
+    LogTracePrint("%s", buffer.c_str());
   }
 }
 
@@ -410,86 +1239,636 @@ void CrashDetect::PrintRuntimeError(AMXRef amx,
   }
 }
 
+void CrashDetect::PrintExecHistory(std::ostream &stream) {
+  unsigned int num_entries = exec_history_.GetNumEntries();
+  if (num_entries == 0) {
+    return;
+  }
+
+  AMXStackFramePrinter printer(stream, debug_info_);
+  stream << "Execution history (most recent last):";
+
+  for (unsigned int i = 0; i < num_entries; i++) {
+    AMXExecHistory::Entry entry = exec_history_.GetEntry(i);
+    cell *ip = reinterpret_cast<cell*>(amx_.GetCode() + entry.from);
+    cell opcode = *ip;
+
+    stream << "\n#" << i << " ";
+    if (opcode == RelocateAMXOpcode(AMX_OP_CALL)
+        || opcode == RelocateAMXOpcode(AMX_OP_CALL_PRI)) {
+      stream << "call";
+    } else if (opcode == RelocateAMXOpcode(AMX_OP_RET)
+               || opcode == RelocateAMXOpcode(AMX_OP_RETN)) {
+      stream << "return";
+    } else {
+      stream << "jump";
+    }
+
+    cell addresses[] = {entry.from, entry.to};
+    for (int j = 0; j < 2; j++) {
+      cell address = addresses[j];
+      stream << (j == 0 ? " from " : " to ");
+      printer.PrintAddress(address);
+      if (debug_info_.IsLoaded()) {
+        std::string function = debug_info_.GetFunctionName(address);
+        stream << " (" << (function.empty() ? "??" : function) << " at ";
+        printer.PrintSourceLocation(address);
+        stream << ")";
+      } else {
+        PrintSymbolName(stream, address);
+      }
+    }
+  }
+}
+
+void CrashDetect::PrintHeapProfile(std::ostream &stream) {
+  AMXStackFramePrinter printer(stream, debug_info_);
+  stream << "Heap allocation profile of " << amx_name_ << ":";
+
+  std::vector<AMXHeapProfiler::Site> sites = heap_profiler_.GetSites();
+  for (std::size_t i = 0; i < sites.size(); i++) {
+    const AMXHeapProfiler::Site &site = sites[i];
+    stream << "\n#" << i << " " << site.bytes << " bytes in "
+           << site.count << " allocations, peak " << site.peak_bytes
+           << " bytes, average lifetime "
+           << std::chrono::duration_cast<std::chrono::microseconds>(
+                site.GetAverageLifetime()).count()
+           << " us";
+
+    if (site.address == AMXHeapProfiler::kHostSite) {
+      stream << " in arguments of public functions";
+      continue;
+    }
+
+    cell *ip = reinterpret_cast<cell*>(amx_.GetCode() + site.address);
+    if (*ip == RelocateAMXOpcode(AMX_OP_SYSREQ_C)) {
+      const char *native = amx_.GetNativeName(*(ip + 1));
+      stream << " in native " << (native != nullptr ? native : "<unknown>");
+    }
+    stream << " at ";
+    printer.PrintAddress(site.address);
+    if (debug_info_.IsLoaded()) {
+      std::string function = debug_info_.GetFunctionName(site.address);
+      stream << " (" << (function.empty() ? "??" : function) << " at ";
+      printer.PrintSourceLocation(site.address);
+      stream << ")";
+    } else {
+      PrintSymbolName(stream, site.address);
+    }
+  }
+}
+
+void CrashDetect::PrintSymbolName(std::ostream &stream, cell address) {
+  const AMXSymbolIndex::Symbol *symbol = AMXSymbolIndex::Lookup(amx_, address);
+  if (symbol != nullptr && !symbol->name.empty()) {
+    stream << " (" << (symbol->is_public ? "public " : "") << symbol->name
+           << ")";
+  }
+}
+
+const char *CrashDetect::GetPublicName(int index) const {
+  if (index == AMX_EXEC_CONT) {
+    return "<continued>";
+  }
+  const char *name = amx_.GetPublicName(index);
+  return name != nullptr ? name : "<unknown>";
+}
+
+std::string CrashDetect::GetFunctionName(cell address) const {
+  if (debug_info_.IsLoaded()) {
+    std::string name = debug_info_.GetFunctionName(address);
+    if (!name.empty()) {
+      return name;
+    }
+  }
+  if (const char *name = amx_.FindPublic(address)) {
+    return name;
+  }
+  const AMXSymbolIndex::Symbol *symbol = AMXSymbolIndex::Lookup(amx_, address);
+  if (symbol != nullptr && symbol->start == address && !symbol->name.empty()) {
+    return symbol->name;
+  }
+  std::stringstream stream;
+  stream << std::hex << std::setw(8) << std::setfill('0') << address;
+  return stream.str();
+}
+
+void CrashDetect::PrintInstructionCounts(std::ostream &stream) {
+  stream << "Instruction counts of " << amx_name_ << ": "
+         << instruction_meter_.total() << " in total";
+
+  std::vector<std::pair<int, AMXInstructionMeter::Counter>> publics =
+    instruction_meter_.GetPublics();
+  for (std::size_t i = 0; i < publics.size(); i++) {
+    const AMXInstructionMeter::Counter &counter = publics[i].second;
+    stream << "\npublic " << GetPublicName(publics[i].first) << ": "
+           << counter.instructions << " in " << counter.calls << " calls, "
+           << counter.instructions / std::max(counter.calls, 1UL)
+           << " per call";
+  }
+
+  // The full list may be very long; the report file has all of them.
+  std::vector<std::pair<cell, AMXInstructionMeter::Counter>> functions =
+    instruction_meter_.GetFunctions();
+  std::size_t num_printed = std::min(functions.size(),
+                                     static_cast<std::size_t>(20));
+  for (std::size_t i = 0; i < num_printed; i++) {
+    const AMXInstructionMeter::Counter &counter = functions[i].second;
+    stream << "\nfunction " << GetFunctionName(functions[i].first) << ": "
+           << counter.instructions << " in " << counter.calls << " calls";
+  }
+  if (functions.size() > num_printed) {
+    stream << "\n... " << functions.size() - num_printed << " more functions";
+  }
+}
+
+// Writes one tab-separated line per public and function:
+// kind, name, address, instructions, calls.
+void CrashDetect::WriteInstructionReport(std::ostream &stream) {
+  stream << "total\t" << amx_name_ << "\t0\t"
+         << instruction_meter_.total() << "\t0\n";
+
+  std::vector<std::pair<int, AMXInstructionMeter::Counter>> publics =
+    instruction_meter_.GetPublics();
+  for (std::size_t i = 0; i < publics.size(); i++) {
+    const AMXInstructionMeter::Counter &counter = publics[i].second;
+    stream << "public\t" << GetPublicName(publics[i].first) << "\t"
+           << amx_.GetPublicAddress(publics[i].first) << "\t"
+           << counter.instructions << "\t" << counter.calls << "\n";
+  }
+
+  std::vector<std::pair<cell, AMXInstructionMeter::Counter>> functions =
+    instruction_meter_.GetFunctions();
+  for (std::size_t i = 0; i < functions.size(); i++) {
+    const AMXInstructionMeter::Counter &counter = functions[i].second;
+    stream << "function\t" << GetFunctionName(functions[i].first) << "\t"
+           << functions[i].first << "\t"
+           << counter.instructions << "\t" << counter.calls << "\n";
+  }
+}
+
+void CrashDetect::PrintStackUsage(std::ostream &stream) {
+  AMXStackAnalyzer analyzer(amx_);
+  if (!analyzer.Analyze()) {
+    stream << "Could not analyze stack usage of " << amx_name_
+           << ": invalid instruction in code";
+    return;
+  }
+
+  const AMX_HEADER *hdr = amx_.GetHeader();
+  std::vector<std::pair<int, AMXStackAnalyzer::Usage>> publics;
+  if (hdr->cip >= 0) {
+    publics.push_back(std::make_pair(AMX_EXEC_MAIN,
+                                     analyzer.GetUsage(hdr->cip)));
+  }
+  for (int i = 0; i < amx_.GetNumPublics(); i++) {
+    publics.push_back(std::make_pair(i,
+      analyzer.GetUsage(amx_.GetPublicAddress(i))));
+  }
+  std::stable_sort(publics.begin(), publics.end(),
+    [](const std::pair<int, AMXStackAnalyzer::Usage> &lhs,
+       const std::pair<int, AMXStackAnalyzer::Usage> &rhs) {
+      return lhs.second.size > rhs.second.size;
+    });
+
+  cell available = (hdr->stp - hdr->hea) / sizeof(cell);
+  stream << "Stack usage of " << amx_name_ << ": " << available
+         << " cells available";
+  if (publics.empty()) {
+    return;
+  }
+
+  std::size_t num_printed = std::min(publics.size(),
+                                     static_cast<std::size_t>(10));
+  for (std::size_t i = 0; i < num_printed; i++) {
+    const AMXStackAnalyzer::Usage &usage = publics[i].second;
+    stream << "\npublic " << GetPublicName(publics[i].first) << ": "
+           << usage.size / sizeof(cell) << " cells";
+    if (usage.recursive) {
+      stream << " or more (recursive)";
+    }
+    if (usage.dynamic) {
+      stream << ", modifies STK/FRM/HEA directly";
+    }
+  }
+
+  const AMXStackAnalyzer::Usage &deepest = publics.front().second;
+  stream << "\nDeepest path: ";
+  for (std::size_t i = 0; i < deepest.path.size(); i++) {
+    if (i > 0) {
+      stream << " -> ";
+    }
+    stream << GetFunctionName(deepest.path[i]);
+  }
+
+  const std::set<cell> &recursive = analyzer.recursive_functions();
+  if (!recursive.empty()) {
+    stream << "\nRecursive functions:";
+    for (std::set<cell>::const_iterator it = recursive.begin();
+         it != recursive.end(); ++it) {
+      stream << " " << GetFunctionName(*it);
+    }
+  }
+
+  // Leave a 25% margin for the arguments of publics, natives calling back
+  // into the script and the like, rounded up to a multiple of 1024 cells.
+  cell needed = deepest.size / sizeof(cell);
+  cell recommended = (needed + needed / 4 + 1023) / 1024 * 1024;
+  stream << "\nRecommended: #pragma dynamic " << recommended;
+  if (needed > available) {
+    stream << " (current size is too small)";
+  }
+}
+
+void CrashDetect::WriteCallGraph(const std::string &dir) {
+  std::shared_ptr<const AMXCallGraph> graph = AMXCallGraphs::GetGraph(amx_);
+  if (!graph->IsComplete()) {
+    LogDebugPrint("Call graph of %s is incomplete: invalid instruction in code",
+                  amx_name_.c_str());
+  }
+
+  AMXCallGraph::NameResolver resolver = [this](cell address) {
+    return GetFunctionName(address);
+  };
+  std::string path = dir + fileutils::kNativePathSepChar + amx_name_;
+  if (!fileutils::MakeDirectory(dir)) {
+    LogDebugPrint("Could not write call graph to %s", dir.c_str());
+    return;
+  }
+
+  std::ofstream dot((path + ".dot").c_str());
+  if (dot.is_open()) {
+    graph->WriteDot(dot, amx_name_, resolver);
+  } else {
+    LogDebugPrint("Could not write call graph to %s.dot", path.c_str());
+  }
+  std::ofstream json((path + ".json").c_str());
+  if (json.is_open()) {
+    graph->WriteJson(json, amx_name_, resolver);
+  } else {
+    LogDebugPrint("Could not write call graph to %s.json", path.c_str());
+  }
+}
+
 // static
 void CrashDetect::PrintAMXBacktrace() {
-  std::stringstream stream;
-  PrintAMXBacktrace(stream);
-  PrintStream(LogDebugPrint, stream);
+  // May be called from a signal handler (see OnCrash()).
+  if (const ThreadState *state = current_thread_state_) {
+    LogFormatBuffer buffer;
+    PrintAMXBacktrace(buffer, state->call_stack);
+  }
 }
 
 // static
 void CrashDetect::PrintAMXBacktrace(std::ostream &stream) {
-  if (call_stack_.IsEmpty()) {
+  PrintAMXBacktrace(stream, call_stack());
+}
+
+// static
+void CrashDetect::PrintAMXBacktrace(std::ostream &stream,
+                                    const AMXCallStack &call_stack,
+                                    bool live_registers) {
+  StreamFormatBuffer buffer(stream);
+  PrintAMXBacktrace(buffer, call_stack, live_registers);
+}
+
+// static
+void CrashDetect::PrintAMXBacktrace(FormatBuffer &buffer,
+                                    const AMXCallStack &call_stack,
+                                    bool live_registers) {
+  std::vector<BacktraceCall> backtrace =
+    GetAMXBacktrace(call_stack, live_registers);
+  if (backtrace.empty()) {
     return;
   }
 
-  AMXRef amx = call_stack_.Top().amx();
-  AMXRef top_amx = amx;
-
-  AMXCallStack calls = call_stack_;
+  // Name the script of every frame if the calls span more than one script.
+  bool multiple_scripts = false;
+  for (std::size_t k = 1; k < backtrace.size(); k++) {
+    if (backtrace[k].call.amx() != backtrace[0].call.amx()) {
+      multiple_scripts = true;
+    }
+  }
 
-  cell cip = top_amx.GetCip();
-  cell frm = top_amx.GetFrm();
+  buffer.Append("AMX backtrace:");
   int level = 0;
 
-  if (!calls.IsEmpty() && cip != 0) {
-    stream << "AMX backtrace:";
-  }
-
-  while (!calls.IsEmpty() && cip != 0 && amx == top_amx) {
-    AMXCall call = calls.Pop();
+  for (std::size_t k = 0; k < backtrace.size(); k++) {
+    const AMXCall &call = backtrace[k].call;
+    AMXRef amx = call.amx();
 
     // native function
     if (call.IsNative()) {
       const char *name = amx.GetNativeName(call.index());
-      stream << "\n#" << level++
-             << " native "
-             << (name != nullptr ? name : "<unknown>") << " ()";
+      buffer.AppendNewLine();
+      buffer.Append("#").AppendInt(level++)
+            .Append(" native ")
+            .Append(name != nullptr ? name : "<unknown>").Append(" ()");
       std::string module = os::GetModuleName(
         reinterpret_cast<void*>(amx.GetNativeAddress(call.index())));
       if (!module.empty()) {
-        stream << " in " << fileutils::GetFileName(module);
+        buffer.Append(" in ").Append(fileutils::GetFileName(module).c_str());
       }
+      continue;
     }
 
     // public function
-    else if (call.IsPublic()) {
-      CrashDetect *handler = GetHandler(amx);
+    CrashDetect *handler = GetHandler(amx);
+    const std::deque<AMXStackFrame> &frames = backtrace[k].frames;
+    AMXStackFramePrinter printer(buffer, handler->debug_info_);
+
+    bool print_amx_name = multiple_scripts
+                          || !handler->debug_info_.IsLoaded();
+
+    if (backtrace[k].running) {
+      buffer.AppendNewLine();
+      buffer.Append("#").AppendInt(level++).Append(" ");
+      printer.PrintCallerName(frames[0]);
+      buffer.Append(" () (running)");
+      if (print_amx_name) {
+        buffer.Append(" in ").Append(handler->amx_name_.c_str());
+      }
+      continue;
+    }
 
-      AMXStackTrace trace = GetAMXStackTrace(amx, frm, cip, 100);
-      std::deque<AMXStackFrame> frames;
+    for (std::size_t i = 0; i < frames.size(); ) {
+      std::size_t period;
+      std::size_t repeats = FindRepeatedFrames(frames, i, period);
 
-      while (trace.current_frame().return_address() != 0) {
-        frames.push_back(trace.current_frame());
-        if (!trace.MoveNext()) {
-          break;
+      // With recursion, print the first round of calls in full and
+      // summarize the rest.
+      for (std::size_t j = i; j < i + period; j++) {
+        buffer.AppendNewLine();
+        buffer.Append("#").AppendInt(level++).Append(" ");
+        printer.Print(frames[j]);
+
+        if (print_amx_name) {
+          buffer.Append(" in ").Append(handler->amx_name_.c_str());
         }
       }
-
-      cell entry_point = amx.GetPublicAddress(call.index());
-      if (frames.empty()) {
-        AMXStackFrame fake_frame(amx, frm, 0, 0, entry_point);
-        frames.push_front(fake_frame);
-      } else {
-        frames.back().set_caller_address(entry_point);
+      if (repeats > 1) {
+        std::size_t num_skipped = period * (repeats - 1);
+        buffer.AppendNewLine();
+        buffer.Append("frames ").AppendInt(level)
+              .Append("-").AppendInt(level + num_skipped - 1)
+              .Append(": ");
+        for (std::size_t j = i; j < i + period; j++) {
+          if (j > i) {
+            buffer.Append(" -> ");
+          }
+          printer.PrintCallerName(frames[j]);
+          buffer.Append("()");
+        }
+        buffer.Append(" repeated");
+        level += static_cast<int>(num_skipped);
       }
+      i += period * repeats;
+    }
+  }
+}
+
+// static
+void CrashDetect::PrintOtherThreadsAMXBacktraces(std::ostream &stream) {
+  std::unique_lock<std::mutex> lock(threads_mutex_, std::defer_lock);
+  if (!TryLockBriefly(lock)) {
+    return;
+  }
+  for (std::vector<ThreadState*>::const_iterator it = threads_.begin();
+       it != threads_.end(); it++) {
+    ThreadState *state = *it;
+    if (state == current_thread_state_) {
+      continue;
+    }
+    PrintThreadAMXBacktrace(stream, *state);
+  }
+}
+
+// static
+void CrashDetect::PrintThreadAMXBacktrace(std::ostream &stream,
+                                          ThreadState &state) {
+  // The thread keeps running and may push or pop calls while its stack is
+  // being copied; try again until a copy isn't torn by such a change.
+  AMXCallStack call_stack;
+  bool copied = false;
+  for (int i = 0; i < kMaxLockAttempts && !copied; i++) {
+    unsigned int seq = state.call_stack_seq.load(std::memory_order_acquire);
+    if ((seq & 1) == 0) {
+      call_stack.CopyFrom(state.call_stack);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      copied =
+        state.call_stack_seq.load(std::memory_order_relaxed) == seq;
+    }
+    if (!copied) {
+      std::this_thread::yield();
+    }
+  }
+  if (!copied) {
+    if (stream.tellp() > 0) {
+      stream << "\n";
+    }
+    stream << "Thread " << state.id << ": call stack is busy";
+    return;
+  }
+  if (call_stack.IsEmpty()) {
+    return;
+  }
+  if (stream.tellp() > 0) {
+    stream << "\n";
+  }
+  stream << "Thread " << state.id << ":\n";
+  PrintAMXBacktrace(stream, call_stack, false);
+}
 
-      for (std::deque<AMXStackFrame>::const_iterator it = frames.begin();
-           it != frames.end(); it++) {
-        const AMXStackFrame &frame = *it;
+// static
+void CrashDetect::DumpState() {
+  LogDebugPrint("State dump requested");
 
-        stream << "\n#" << level++ << " ";
-        frame.Print(stream, handler->debug_info_);
+  std::stringstream stream;
+  if (!call_stack().IsEmpty()) {
+    PrintAMXBacktrace(stream);
+  }
+  PrintOtherThreadsAMXBacktraces(stream);
+  PrintStream(LogDebugPrint, stream);
 
-        if (!handler->debug_info_.IsLoaded()) {
-          stream << " in " << handler->amx_name_;
-        }
+  ForEachHandler([](CrashDetect *handler) {
+    std::stringstream script_stream;
+    handler->PrintState(script_stream);
+    PrintStream(LogDebugPrint, script_stream);
+  });
+
+  TickProfiler &tick_profiler = TickProfiler::shared();
+  if (tick_profiler.IsEnabled()) {
+    std::stringstream tick_stream;
+    tick_stream << "Last tick: " << tick_profiler.last_tick_time().count()
+                << " us spent in scripts\n";
+    tick_profiler.PrintHistogram(tick_stream);
+    PrintStream(LogDebugPrint, tick_stream);
+  }
+}
+
+void CrashDetect::PrintState(std::ostream &stream) {
+  // Between calls the stack is empty, so this mostly shows what is left on
+  // the heap; during a call it is what the call is using right now.
+  cell heap_used = amx_.GetHea() - amx_.GetHlw();
+  cell stack_used = amx_.GetStp() - amx_.GetStk();
+  cell total = amx_.GetStp() - amx_.GetHlw();
+  stream << "Script " << amx_name_ << ": heap " << heap_used
+         << " bytes, stack " << stack_used << " bytes, "
+         << total - heap_used - stack_used << " of " << total
+         << " bytes free";
+  if (TickProfiler::shared().IsEnabled()) {
+    stream << ", " << TickProfiler::shared().GetLastTickTime(amx_).count()
+           << " us in last tick";
+  }
+
+  if (!heap_profiler_.IsEmpty()) {
+    stream << "\n";
+    PrintHeapProfile(stream);
+  }
+  if (ext_hooks_.meter != nullptr) {
+    stream << "\n";
+    PrintInstructionCounts(stream);
+  }
+  if (exec_history_.GetNumEntries() != 0) {
+    stream << "\n";
+    PrintExecHistory(stream);
+  }
+}
+
+// static
+bool CrashDetect::TakeSnapshot(const std::string &reason) {
+  static std::atomic<int> count(0);
+  static std::atomic<std::time_t> last_time(0);
+
+  // Don't flood the disk when errors happen in a loop.
+  std::time_t now = std::time(nullptr);
+  if (last_time.exchange(now) == now) {
+    return false;
+  }
+
+  char time_string[32];
+  std::strftime(time_string, sizeof(time_string),
+                "%Y%m%d-%H%M%S", std::localtime(&now));
+
+  std::stringstream path_stream;
+  path_stream << Options::shared().snapshot_dir()
+              << fileutils::kNativePathSepChar
+              << "snapshot-" << time_string << "-" << ++count;
+  std::string path = path_stream.str();
+
+  if (!fileutils::MakeDirectory(path)) {
+    LogDebugPrint("Could not save snapshot to %s", path.c_str());
+    return false;
+  }
+
+  // Everything is formatted here: the forked process may only make
+  // async-signal-safe calls, so all it does is write out these buffers and
+  // its copy of the script data.
+  std::stringstream index_stream;
+  std::vector<os::FileData> files;
+  FormatSnapshot(path, reason, index_stream, files);
+  std::string index = index_stream.str();
+  os::FileData index_file = {
+    path + fileutils::kNativePathSepChar + "snapshot.txt",
+    index.data(),
+    index.size()
+  };
+  files.insert(files.begin(), index_file);
+
+  if (!os::WriteFilesInBackground(files)) {
+    for (std::vector<os::FileData>::const_iterator it = files.begin();
+         it != files.end(); it++) {
+      std::ofstream file(it->path.c_str(), std::ios::binary);
+      file.write(static_cast<const char*>(it->data), it->size);
+      if (!file) {
+        LogDebugPrint("Could not save snapshot to %s", path.c_str());
+        return false;
       }
+    }
+  }
 
-      frm = call.frm();
-      cip = call.cip();
+  LogDebugPrint("Saving snapshot to %s", path.c_str());
+  return true;
+}
+
+// static
+void CrashDetect::FormatSnapshot(const std::string &path,
+                                 const std::string &reason,
+                                 std::ostream &index,
+                                 std::vector<os::FileData> &files) {
+  index << "Reason: " << reason << "\n";
+  index << "\nCall stack (most recent first):";
+
+  AMXCallStack calls = call_stack();
+  int level = 0;
+  while (!calls.IsEmpty()) {
+    AMXCall call = calls.Pop();
+    AMXRef amx = call.amx();
+    const char *name = nullptr;
+    if (call.IsNative()) {
+      name = amx.GetNativeName(call.index());
+    } else {
+      name = call.index() == AMX_EXEC_MAIN
+        ? "main" : amx.GetPublicName(call.index());
     }
+    index << "\n#" << level++
+          << (call.IsNative() ? " native " : " public ")
+          << (name != nullptr ? name : "<unknown>")
+          << " in " << GetHandler(amx)->amx_name_;
+  }
+
+  std::stringstream backtrace;
+  PrintAMXBacktrace(backtrace);
+  index << "\n\n" << backtrace.str() << "\n";
+
+  std::stringstream threads;
+  PrintOtherThreadsAMXBacktraces(threads);
+  if (threads.tellp() > 0) {
+    index << "\nOther threads:\n" << threads.str() << "\n";
+  }
+
+  index << "\nScripts:\n";
+  int number = 0;
+  ForEachHandler([&](CrashDetect *handler) {
+    handler->FormatSnapshotData(path, number++, index, files);
+  });
+}
+
+void CrashDetect::FormatSnapshotData(const std::string &path,
+                                     int number,
+                                     std::ostream &index,
+                                     std::vector<os::FileData> &files) {
+  std::stringstream file_name;
+  file_name << number << "-" << amx_name_ << ".data";
+
+  const char *registers[] = {
+    "CIP", "FRM", "STK", "HEA", "HLW", "STP", "PRI", "ALT"
+  };
+  cell values[] = {
+    amx_.GetCip(), amx_.GetFrm(), amx_.GetStk(), amx_.GetHea(),
+    amx_.GetHlw(), amx_.GetStp(), amx_.GetPri(), amx_.GetAlt()
+  };
+
+  index << "\n" << amx_name_ << ":\n"
+        << "  Path: " << (amx_path_.empty() ? "<unknown>" : amx_path_) << "\n"
+        << "  Debug info: " << (debug_info_.IsLoaded() ? "yes" : "no") << "\n"
+        << " ";
+  char old_fill = index.fill('0');
+  for (std::size_t i = 0; i < sizeof(values) / sizeof(*values); i++) {
+    index << " " << registers[i] << ": "
+          << std::hex << std::setw(8) << values[i] << std::dec;
   }
+  index.fill(old_fill);
+  index << "\n  Data: " << file_name.str()
+        << " (" << amx_.GetStp() << " bytes)\n";
+
+  // The data section includes the heap and the stack.
+  os::FileData data = {
+    path + fileutils::kNativePathSepChar + file_name.str(),
+    amx_.GetData(),
+    static_cast<std::size_t>(amx_.GetStp())
+  };
+  files.push_back(data);
 }
 
 // static
@@ -549,21 +1928,50 @@ void CrashDetect::PrintLoadedModules() {
   }
 }
 
-// static
 void CrashDetect::Push(AMXCall call) {
-  if (call_stack_.IsEmpty()) {
-    long_call_time_next_ =
-        std::chrono::high_resolution_clock::now() + long_call_time_current_;
+  if (call_stack().IsEmpty()) {
+    std::chrono::microseconds budget = long_call_time_current_;
+    if (call.IsPublic()) {
+      budget = GetPublicLongCallBudget(call.index());
+    }
+    thread_state_.long_call_amx = call.amx();
+    thread_state_.long_call_index = call.index();
+    thread_state_.long_call_budget = budget;
+    thread_state_.long_call_detected = false;
+    StartLongCallTimer();
+  }
+  {
+    CallStackChange change(thread_state_.call_stack_seq);
+    call_stack().Push(call);
+  }
+  if (&thread_state_ == main_thread_state_) {
+    Watchdog::shared().Feed();
   }
-  call_stack_.Push(call);
+}
+
+std::chrono::microseconds CrashDetect::GetPublicLongCallBudget(
+    cell index) const {
+  std::chrono::microseconds budget = long_call_budgets_[index + 2];
+  return budget.count() >= 0 ? budget : long_call_time_current_;
 }
 
 // static
 AMXCall CrashDetect::Pop() {
-  AMXCall call = call_stack_.Pop();
-  if (call_stack_.IsEmpty()) {
-    long_call_time_next_ =
+  AMXCall call = [] {
+    CallStackChange change(thread_state_.call_stack_seq);
+    return call_stack().Pop();
+  }();
+  if (&thread_state_ == main_thread_state_) {
+    Watchdog::shared().Feed();
+  }
+  if (call_stack().IsEmpty()) {
+    thread_state_.long_call_time_next =
+        std::chrono::high_resolution_clock::time_point::max();
+    thread_state_.long_call_profile_next =
         std::chrono::high_resolution_clock::time_point::max();
+    if (thread_state_.long_call_profile.IsActive()) {
+      FinishLongCallProfile();
+    }
   }
   return call;
 }
@@ -579,7 +1987,12 @@ void CrashDetect::PrintNativeBacktrace(std::ostream &stream,
                                        const os::Context &context) {
   std::vector<StackFrame> frames;
   GetStackTrace(frames, context.native_context());
+  PrintNativeBacktrace(stream, frames);
+}
 
+// static
+void CrashDetect::PrintNativeBacktrace(std::ostream &stream,
+                                       const std::vector<StackFrame> &frames) {
   if (!frames.empty()) {
     stream << "Native backtrace:";
 
@@ -614,8 +2027,7 @@ unsigned int CrashDetect::LongCallOption(int option) {
     case AMX_LCT_OPTION_ACTIVE:
       return long_call_time_running_;
     case AMX_LCT_OPTION_RESTART:
-      long_call_time_next_ =
-          std::chrono::high_resolution_clock::now() + long_call_time_current_;
+      StartLongCallTimer();
       break;
     case AMX_LCT_OPTION_DISABLE:
       long_call_time_running_ = false;
@@ -631,15 +2043,132 @@ unsigned int CrashDetect::LongCallOption(int option) {
 }
 
 // static
-void CrashDetect::CheckLongCallTime(void) {
+void CrashDetect::StartLongCallTimer() {
+  ThreadState &state = thread_state_;
+  state.long_call_profile.Stop();
+  if (state.long_call_budget.count() == 0) {
+    state.long_call_time_next =
+        std::chrono::high_resolution_clock::time_point::max();
+    state.long_call_profile_next =
+        std::chrono::high_resolution_clock::time_point::max();
+    return;
+  }
+
+  std::chrono::high_resolution_clock::time_point now =
+      std::chrono::high_resolution_clock::now();
+  state.long_call_time_next = now + state.long_call_budget;
+
+  unsigned int profile_percent = Options::shared().long_call_profile();
+  if (profile_percent != 0) {
+    state.long_call_profile_next =
+        now + state.long_call_budget * profile_percent / 100;
+  } else {
+    state.long_call_profile_next =
+        std::chrono::high_resolution_clock::time_point::max();
+  }
+}
+
+void CrashDetect::CheckLongCallTime() {
+  CheckDumpRequest();
+
   if (!long_call_time_running_) {
     return;
   }
-  if (long_call_time_next_ < std::chrono::high_resolution_clock::now()) {
+
+  ThreadState &state = thread_state_;
+  std::chrono::high_resolution_clock::time_point now =
+      std::chrono::high_resolution_clock::now();
+
+  if (state.long_call_profile.IsActive()) {
+    SampleLongCall(now);
+    if (state.long_call_profile.IsExpired(now)) {
+      if (state.long_call_detected) {
+        FinishLongCallProfile();
+      } else {
+        // Keep only the most recent part of a call that is slow but hasn't
+        // gone over budget yet.
+        state.long_call_profile.Start(now);
+      }
+    }
+  } else if (state.long_call_profile_next < now) {
+    state.long_call_profile_next =
+        std::chrono::high_resolution_clock::time_point::max();
+    state.long_call_profile.Start(now);
+  }
+
+  if (state.long_call_time_next < now) {
     // Disable repeat stack dumps by setting this WAY in the future.
-    long_call_time_next_ =
+    state.long_call_time_next =
         std::chrono::high_resolution_clock::time_point::max();
+    state.long_call_detected = true;
+    CRASHDETECT_PROBE4(long_call, amx(), state.long_call_index, amx_.GetCip(),
+                       state.long_call_budget.count());
     LogDebugPrint("Long callback execution detected (hang or performance issue)");
     PrintAMXBacktrace();
+    if (Options::shared().snapshot_flags() & SNAPSHOT_ON_LONG_CALL) {
+      TakeSnapshot("long callback execution");
+    }
+  }
+}
+
+// static
+void CrashDetect::SampleLongCall(
+    std::chrono::high_resolution_clock::time_point now) {
+  // The long call is the outermost call of the thread, so the sample has to
+  // include the scripts that called the current one through natives.
+  std::vector<BacktraceCall> backtrace = GetAMXBacktrace(call_stack(), true);
+  if (backtrace.empty()) {
+    return;
+  }
+
+  char storage[1024];
+  FormatBuffer buffer(storage, sizeof(storage));
+  for (std::size_t k = backtrace.size(); k-- > 0; ) {
+    const AMXCall &call = backtrace[k].call;
+    if (call.IsNative()) {
+      const char *name = call.amx().GetNativeName(call.index());
+      buffer.Append(name != nullptr ? name : "<unknown>");
+    } else {
+      const std::deque<AMXStackFrame> &frames = backtrace[k].frames;
+      AMXStackFramePrinter printer(buffer,
+                                   GetHandler(call.amx())->debug_info_);
+      for (std::size_t i = frames.size(); i-- > 0; ) {
+        printer.PrintCallerName(frames[i]);
+        if (i > 0) {
+          buffer.Append(';');
+        }
+      }
+    }
+    if (k > 0) {
+      buffer.Append(';');
+    }
+  }
+  thread_state_.long_call_profile.AddSample(buffer.c_str(), now);
+}
+
+// static
+void CrashDetect::FinishLongCallProfile() {
+  ThreadState &state = thread_state_;
+  state.long_call_profile.Stop();
+  if (!state.long_call_detected) {
+    return;
+  }
+
+  AMXRef amx(state.long_call_amx);
+  const char *name = amx.GetPublicName(state.long_call_index);
+
+  std::stringstream stream;
+  state.long_call_profile.Print(stream, name != nullptr ? name : "<unknown>");
+  PrintStream(LogDebugPrint, stream);
+}
+
+// static
+void CrashDetect::CheckDumpRequest() {
+  // Profilers and the heap are only consistent on the main thread.
+  if (&thread_state_ != main_thread_state_
+      || !dump_requested_.load(std::memory_order_relaxed)) {
+    return;
   }
+  dump_requested_.store(false, std::memory_order_relaxed);
+  DumpState();
 }
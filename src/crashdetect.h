@@ -25,26 +25,50 @@
 #ifndef CRASHDETECT_H
 #define CRASHDETECT_H
 
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdio>
 #include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 #include "amxcallstack.h"
 #include "amxdebuginfo.h"
+#include "amxexechistory.h"
 #include "amxhandler.h"
+#include "amxheapprofiler.h"
+#include "amxinstructionmeter.h"
+#include "amxrecording.h"
 #include "amxref.h"
+#include "amxwatchpoints.h"
+#include "longcallprofile.h"
 #include "regexp.h"
 
 class AMXStackFrame;
+class FormatBuffer;
+class StackFrame;
 
 namespace os {
   class Context;
+  struct FileData;
 }
 
 class CrashDetect: public AMXHandler<CrashDetect> {
  public:
   friend class AMXHandler<CrashDetect>; // for accessing private ctor
 
+  // Statistics of a benchmark run, in nanoseconds.
+  struct BenchmarkResult {
+    int num_samples;
+    int num_outliers;
+    long long min;
+    long long median;
+    long long p99;
+    long long mean;
+  };
+
   int Load();
   int Unload();
 
@@ -54,34 +78,127 @@ class CrashDetect: public AMXHandler<CrashDetect> {
   int OnExecError(int index, cell *retval, int error);
   int OnLongCallRequest(int option, int value);
   int OnAddressNaughtRequest(int option);
+  int OnWatch(cell address, cell size);
+  int OnHeapChange(cell cip, cell from, cell to);
+  int OnMeterEvent(int event, cell cip);
+
+  bool WatchVariable(const std::string &name);
+  bool WatchAddress(cell address, cell num_cells);
+  bool UnwatchVariable(const std::string &name);
+  bool UnwatchAddress(cell address);
+
+  // Sets the long call time limit of the publics matching a wildcard pattern
+  // and returns how many there were. A negative time restores the default.
+  int SetLongCallBudget(const std::string &pattern, long long time);
+  long long GetLongCallBudget(const std::string &name) const;
+
+  // Instruction counts; -1 if the public or function is not known or has
+  // never been called.
+  long long GetInstructionCount() const;
+  long long GetPublicInstructionCount(const std::string &name) const;
+  long long GetFunctionInstructionCount(const std::string &name) const;
+  void ResetInstructionCounts() { instruction_meter_.Clear(); }
+
+  // Calls a public function (with no arguments) the specified number of
+  // times, after a few warm-up calls, and measures how long each call takes.
+  // Returns an AMX error code.
+  int BenchmarkPublic(const std::string &name,
+                      int iterations,
+                      BenchmarkResult &result);
+
+  void SetBreakpoint(cell address) { breakpoints_.insert(address); }
+  void ClearBreakpoints() { breakpoints_.clear(); }
+
+  const AMXDebugInfo &debug_info() const { return debug_info_; }
+  const std::string &amx_name() const { return amx_name_; }
+
+  AMX_EXT_HOOKS *ext_hooks() { return &ext_hooks_; }
+  AMX_WATCH *watch() { return watchpoints_.watch(); }
+  AMX_METER *meter() { return instruction_meter_.meter(); }
 
  public:
   static void PluginLoad();
   static void PluginUnload();
 
+  static void ProcessTick();
+
   static void OnCrash(const os::Context &context);
   static void OnInterrupt(const os::Context &context);
+  static void OnThreadDump(const os::Context &context,
+                           void *const *stack,
+                           int stack_size);
+  static void OnDumpRequest();
 
   static void PrintAMXBacktrace();
   static void PrintAMXBacktrace(std::ostream &stream);
+  // The registers of the innermost script are only live if the call stack
+  // belongs to the current thread.
+  static void PrintAMXBacktrace(std::ostream &stream,
+                                const AMXCallStack &call_stack,
+                                bool live_registers = true);
+  static void PrintAMXBacktrace(FormatBuffer &buffer,
+                                const AMXCallStack &call_stack,
+                                bool live_registers = true);
+
+  // Prints the backtraces of all other threads that are currently executing
+  // scripts. Not safe to call from a signal handler.
+  static void PrintOtherThreadsAMXBacktraces(std::ostream &stream);
+
+  // Saves the data of all scripts and the call stack to a new directory in
+  // snapshot_dir. Where possible this is done by a forked process so that
+  // the server doesn't have to wait for it.
+  static bool TakeSnapshot(const std::string &reason);
+
+  // Prints the AMX backtraces of all threads, the memory usage, profiler
+  // counters and execution history of every script, and the tick profile.
+  static void DumpState();
 
   static void PrintNativeBacktrace(const os::Context &context);
   static void PrintNativeBacktrace(std::ostream &stream,
                                    const os::Context &context);
+  static void PrintNativeBacktrace(std::ostream &stream,
+                                   const std::vector<StackFrame> &frames);
 
  private:
   static void PrintTraceFrame(const AMXStackFrame &frame,
                               const AMXDebugInfo &debug_info);
   static void PrintRuntimeError(AMXRef amx, const AMX &amx_state, int error);
+  void PrintExecHistory(std::ostream &stream);
+  void PrintHeapProfile(std::ostream &stream);
+  void PrintInstructionCounts(std::ostream &stream);
+  void WriteInstructionReport(std::ostream &stream);
+  void PrintStackUsage(std::ostream &stream);
+  void PrintState(std::ostream &stream);
+  void WriteCallGraph(const std::string &dir);
+  void PrintSymbolName(std::ostream &stream, cell address);
+  const char *GetPublicName(int index) const;
+  std::string GetFunctionName(cell address) const;
+  void UpdateWatchpoints();
+  static void FormatSnapshot(const std::string &path,
+                             const std::string &reason,
+                             std::ostream &index,
+                             std::vector<os::FileData> &files);
+  void FormatSnapshotData(const std::string &path,
+                          int number,
+                          std::ostream &index,
+                          std::vector<os::FileData> &files);
   static void PrintRegisters(const os::Context &context);
   static void PrintStack(const os::Context &context);
   static void PrintLoadedModules();
-  static void Push(AMXCall call);
+  void Push(AMXCall call);
   static AMXCall Pop();
+  std::chrono::microseconds GetPublicLongCallBudget(cell index) const;
+  void LoadLongCallBudgets();
+  static AMXCallStack &call_stack() { return thread_state_.call_stack; }
 
   static void SetLongCallTime(unsigned int time);
   static unsigned int LongCallOption(int option);
-  static void CheckLongCallTime(void);
+  static void StartLongCallTimer();
+  void CheckLongCallTime();
+  static void SampleLongCall(
+      std::chrono::high_resolution_clock::time_point now);
+  static void FinishLongCallProfile();
+  static void CheckDumpRequest();
 
  private:
   CrashDetect(AMX *amx);
@@ -91,6 +208,16 @@ class CrashDetect: public AMXHandler<CrashDetect> {
   AMXDebugInfo debug_info_;
   AMX_DEBUG prev_debug_;
   AMX_CALLBACK prev_callback_;
+  AMX_EXT_HOOKS ext_hooks_;
+  AMXExecHistory exec_history_;
+  AMXWatchpoints watchpoints_;
+  AMXHeapProfiler heap_profiler_;
+  AMXInstructionMeter instruction_meter_;
+  std::unordered_set<cell> breakpoints_;
+  AMXRecordingWriter recording_;
+  // Indexed by public index + 2 to fit AMX_EXEC_MAIN and AMX_EXEC_CONT;
+  // negative values mean that long_call_time applies.
+  std::vector<std::chrono::microseconds> long_call_budgets_;
   cell last_frame_;
   std::string amx_path_;
   std::string amx_name_;
@@ -98,11 +225,44 @@ class CrashDetect: public AMXHandler<CrashDetect> {
   bool address_naught_;
 
  private:
-  static AMXCallStack call_stack_;
+  // Plugins may call amx_Exec() from their own threads (e.g. for async
+  // query callbacks), so the call stack and the long call timer are kept per
+  // thread. All threads' states are also registered in threads_.
+  struct ThreadState {
+    ThreadState();
+    ~ThreadState();
+
+    AMXCallStack call_stack;
+    AMX *long_call_amx;
+    cell long_call_index;
+    std::chrono::microseconds long_call_budget;
+    std::chrono::high_resolution_clock::time_point long_call_time_next;
+    std::chrono::high_resolution_clock::time_point long_call_profile_next;
+    LongCallProfile long_call_profile;
+    bool long_call_detected;
+    std::thread::id id;
+    // Only the owning thread changes call_stack. It increments this before
+    // and after every change, so other threads can tell if their copy of
+    // the stack is torn (odd or changed value).
+    std::atomic<unsigned int> call_stack_seq;
+  };
+
+  static void PrintThreadAMXBacktrace(std::ostream &stream,
+                                      ThreadState &state);
+
+  static thread_local ThreadState thread_state_;
+  // Same as &thread_state_ if it has been created, otherwise null. Unlike
+  // thread_state_ this is safe to use from signal handlers.
+  static thread_local ThreadState *current_thread_state_;
+  static ThreadState *main_thread_state_;
+  static std::mutex threads_mutex_;
+  static std::vector<ThreadState*> threads_;
   static unsigned int long_call_time_;
   static std::chrono::microseconds long_call_time_current_;
-  static std::chrono::high_resolution_clock::time_point long_call_time_next_;
   static bool long_call_time_running_;
+  // Set asynchronously by OnDumpRequest() and handled at the next safe
+  // point on the main thread.
+  static std::atomic<bool> dump_requested_;
 };
 
 #endif // !CRASHDETECT_H
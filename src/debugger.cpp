@@ -0,0 +1,481 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "amxdebuginfo.h"
+#include "amxopcode.h"
+#include "amxref.h"
+#include "amxstacktrace.h"
+#include "crashdetect.h"
+#include "debugger.h"
+#include "log.h"
+
+namespace {
+
+const char kHelp[] =
+  "break <file>:<line> | break <function> - set a breakpoint\n"
+  "clear [<file>:<line> | <function>] - delete a breakpoint (or all)\n"
+  "continue - resume execution\n"
+  "step - stop at the next statement\n"
+  "next - stop at the next statement in this function\n"
+  "finish - stop after the current function returns\n"
+  "pause - stop at the next statement in any script\n"
+  "backtrace - print the call stack\n"
+  "locals [<frame>] - print local variables\n"
+  "print <variable> - print a local or global variable\n"
+  "scripts - list loaded scripts\n";
+
+// Matches either the full name of a source file (as stored in the debug info)
+// or its trailing part, so that "gamemode.pwn" finds "C:\\x\\gamemode.pwn".
+bool MatchFileName(const std::string &name, const std::string &pattern) {
+  if (name.length() < pattern.length()) {
+    return false;
+  }
+  std::string::size_type start = name.length() - pattern.length();
+  if (name.compare(start, pattern.length(), pattern) != 0) {
+    return false;
+  }
+  return start == 0 || name[start - 1] == '/' || name[start - 1] == '\\';
+}
+
+// Returns the address of the first statement of a file:line or function
+// location, or 0 if it doesn't exist in this script.
+cell ResolveLocation(const AMXDebugInfo &debug_info,
+                     const std::string &location) {
+  std::string::size_type colon = location.rfind(':');
+  if (colon == std::string::npos) {
+    return debug_info.GetFunctionAddress(location, "");
+  }
+
+  std::string file = location.substr(0, colon);
+  long line = std::atol(location.c_str() + colon + 1);
+  if (line <= 0) {
+    return 0;
+  }
+
+  AMXDebugInfo::FileTable files = debug_info.GetFiles();
+  for (AMXDebugInfo::FileTable::const_iterator it = files.begin();
+       it != files.end(); ++it) {
+    if (MatchFileName(it->GetName(), file)) {
+      // Line numbers in the debug info start at 0.
+      return debug_info.GetLineAddress(line - 1, it->GetName());
+    }
+  }
+  return 0;
+}
+
+// The debug hook is called from BREAK with CIP pointing past the opcode.
+cell GetHookAddress(AMXRef amx, cell address) {
+  cell *ip = reinterpret_cast<cell*>(amx.GetCode() + address);
+  if (*ip == RelocateAMXOpcode(AMX_OP_BREAK)) {
+    return address + sizeof(cell);
+  }
+  return address;
+}
+
+} // anonymous namespace
+
+Debugger::StepMode Debugger::step_mode_ = Debugger::STEP_NONE;
+
+Debugger::Debugger()
+  : step_amx_(nullptr),
+    step_frm_(0)
+{
+}
+
+bool Debugger::Start(const std::string &path) {
+  return socket_.Listen(path);
+}
+
+void Debugger::Stop() {
+  Detach();
+  socket_.Close();
+}
+
+void Debugger::Poll() {
+  if (!socket_.IsConnected()) {
+    if (!socket_.Accept()) {
+      return;
+    }
+    LogDebugPrint("Debugger client connected");
+  }
+
+  std::string request;
+  while (socket_.ReadLine(request, false)) {
+    HandleRequest(request, nullptr);
+  }
+
+  if (!socket_.IsConnected()) {
+    Detach();
+  }
+}
+
+void Debugger::OnLoad(CrashDetect *handler) {
+  for (std::vector<std::string>::const_iterator it = breakpoints_.begin();
+       it != breakpoints_.end(); it++) {
+    SetBreakpoint(handler, *it);
+  }
+}
+
+bool Debugger::ShouldStep(AMX *amx, cell frm) const {
+  switch (step_mode_) {
+    case STEP_INTO:
+      return true;
+    case STEP_OVER:
+      // The stack grows down, so a greater frame address means that the
+      // function has returned to its caller.
+      return amx == step_amx_ && frm >= step_frm_;
+    case STEP_OUT:
+      return amx == step_amx_ && frm > step_frm_;
+    default:
+      return false;
+  }
+}
+
+void Debugger::Break(CrashDetect *handler, const char *reason) {
+  if (!socket_.IsConnected()) {
+    return;
+  }
+
+  AMXRef amx = handler->amx();
+  step_mode_ = STEP_NONE;
+
+  std::stringstream stream;
+  stream << "stopped " << reason << " " << handler->amx_name() << " ";
+  PrintLocation(stream, handler, amx.GetCip());
+  stream << "\n";
+  socket_.Write(stream.str());
+
+  std::string request;
+  while (socket_.ReadLine(request, true)) {
+    if (HandleRequest(request, handler)) {
+      return;
+    }
+  }
+
+  Detach();
+}
+
+bool Debugger::HandleRequest(const std::string &request,
+                             CrashDetect *handler) {
+  std::istringstream input(request);
+  std::string command;
+  std::string argument;
+  input >> command;
+  std::getline(input >> std::ws, argument);
+
+  if (command.empty()) {
+    return false;
+  }
+  if (command == "help") {
+    Reply(kHelp);
+    return false;
+  }
+  if (command == "break" || command == "b") {
+    if (argument.empty()) {
+      ReplyError("missing location");
+      return false;
+    }
+    int count = SetBreakpoint(argument);
+    std::stringstream reply;
+    reply << "breakpoint set in " << count << " script(s)\n";
+    Reply(reply.str());
+    return false;
+  }
+  if (command == "clear") {
+    int count = ClearBreakpoint(argument);
+    std::stringstream reply;
+    reply << count << " breakpoint(s) deleted\n";
+    Reply(reply.str());
+    return false;
+  }
+  if (command == "pause") {
+    step_mode_ = STEP_INTO;
+    Reply("");
+    return false;
+  }
+  if (command == "scripts") {
+    std::stringstream reply;
+    CrashDetect::ForEachHandler([&reply](CrashDetect *script) {
+      reply << script->amx_name()
+            << (script->debug_info().IsLoaded() ? "" : " (no debug info)")
+            << "\n";
+    });
+    Reply(reply.str());
+    return false;
+  }
+
+  if (handler == nullptr) {
+    ReplyError("not stopped");
+    return false;
+  }
+
+  AMXRef amx = handler->amx();
+
+  if (command == "continue" || command == "c") {
+    socket_.Write("ok\n");
+    return true;
+  }
+  if (command == "step" || command == "s") {
+    step_mode_ = STEP_INTO;
+    socket_.Write("ok\n");
+    return true;
+  }
+  if (command == "next" || command == "n"
+      || command == "finish") {
+    step_mode_ = command == "finish" ? STEP_OUT : STEP_OVER;
+    step_amx_ = amx;
+    step_frm_ = amx.GetFrm();
+    socket_.Write("ok\n");
+    return true;
+  }
+  if (command == "backtrace" || command == "bt") {
+    std::stringstream reply;
+    CrashDetect::PrintAMXBacktrace(reply);
+    reply << "\n";
+    Reply(reply.str());
+    return false;
+  }
+
+  // Find the frame and the code address within that frame: the return
+  // address of each frame points into the function of the next one. The
+  // walker stops at frames that lie outside of the stack or don't go up.
+  int level = argument.empty() || command == "print"
+    ? 0 : std::atoi(argument.c_str());
+  AMXStackWalker walker(amx, amx.GetFrm(), amx.GetCip());
+  AMXStackFrame frame(amx, 0);
+  bool found = false;
+  for (int i = 0; !found && walker.Next(frame); i++) {
+    found = i == level;
+  }
+  cell frm = found ? frame.previous_address() : 0;
+  cell cip = found ? frame.return_address() : 0;
+  if (frm == 0 || cip == 0) {
+    ReplyError("no such frame");
+    return false;
+  }
+
+  if (command == "locals") {
+    if (!handler->debug_info().IsLoaded()) {
+      ReplyError("no debug info");
+      return false;
+    }
+    std::stringstream reply;
+    PrintLocals(reply, handler, frm, cip);
+    Reply(reply.str());
+    return false;
+  }
+  if (command == "print" || command == "p") {
+    if (!handler->debug_info().IsLoaded()) {
+      ReplyError("no debug info");
+      return false;
+    }
+    std::stringstream reply;
+    if (PrintVariable(reply, handler, argument, frm, cip)) {
+      Reply(reply.str());
+    } else {
+      ReplyError("unknown variable");
+    }
+    return false;
+  }
+
+  ReplyError("unknown command");
+  return false;
+}
+
+void Debugger::Detach() {
+  if (socket_.IsConnected() || !breakpoints_.empty()) {
+    LogDebugPrint("Debugger client disconnected");
+  }
+  socket_.Disconnect();
+  step_mode_ = STEP_NONE;
+  breakpoints_.clear();
+  CrashDetect::ForEachHandler([](CrashDetect *handler) {
+    handler->ClearBreakpoints();
+  });
+}
+
+void Debugger::SetBreakpoint(CrashDetect *handler,
+                             const std::string &location) {
+  if (handler->debug_info().IsLoaded()) {
+    cell address = ResolveLocation(handler->debug_info(), location);
+    if (address != 0) {
+      handler->SetBreakpoint(GetHookAddress(handler->amx(), address));
+    }
+  }
+}
+
+int Debugger::SetBreakpoint(const std::string &location) {
+  breakpoints_.push_back(location);
+  int count = 0;
+  CrashDetect::ForEachHandler([&](CrashDetect *handler) {
+    if (handler->debug_info().IsLoaded()
+        && ResolveLocation(handler->debug_info(), location) != 0) {
+      SetBreakpoint(handler, location);
+      count++;
+    }
+  });
+  return count;
+}
+
+int Debugger::ClearBreakpoint(const std::string &location) {
+  int count = 0;
+  for (std::vector<std::string>::iterator it = breakpoints_.begin();
+       it != breakpoints_.end(); ) {
+    if (location.empty() || *it == location) {
+      it = breakpoints_.erase(it);
+      count++;
+    } else {
+      it++;
+    }
+  }
+
+  // Rebuild the breakpoint sets from the remaining locations rather than
+  // trying to figure out which addresses were shared between them.
+  CrashDetect::ForEachHandler([this](CrashDetect *handler) {
+    handler->ClearBreakpoints();
+    OnLoad(handler);
+  });
+  return count;
+}
+
+void Debugger::PrintLocation(std::ostream &stream,
+                             CrashDetect *handler,
+                             cell cip) {
+  const AMXDebugInfo &debug_info = handler->debug_info();
+  AMXStackFramePrinter printer(stream, debug_info);
+  if (debug_info.IsLoaded()) {
+    printer.PrintSourceLocation(cip);
+    std::string function = debug_info.GetFunctionName(cip);
+    if (!function.empty()) {
+      stream << " in " << function;
+    }
+  } else {
+    printer.PrintAddress(cip);
+  }
+}
+
+void Debugger::PrintLocals(std::ostream &stream,
+                           CrashDetect *handler,
+                           cell frm,
+                           cell cip) {
+  AMXDebugInfo::SymbolTable symbols = handler->debug_info().GetSymbols();
+  for (AMXDebugInfo::SymbolTable::const_iterator it = symbols.begin();
+       it != symbols.end(); ++it) {
+    if (it->IsLocal()
+        && !it->IsFunction()
+        && it->GetCodeStart() <= cip && cip < it->GetCodeEnd()) {
+      PrintVariable(stream, handler, it->GetName(), frm, cip);
+    }
+  }
+}
+
+bool Debugger::PrintVariable(std::ostream &stream,
+                             CrashDetect *handler,
+                             const std::string &name,
+                             cell frm,
+                             cell cip) {
+  const AMXDebugInfo &debug_info = handler->debug_info();
+  AMXRef amx = handler->amx();
+
+  // Locals shadow globals, and inner blocks are listed after outer ones.
+  AMXDebugSymbol symbol;
+  AMXDebugInfo::SymbolTable symbols = debug_info.GetSymbols();
+  for (AMXDebugInfo::SymbolTable::const_iterator it = symbols.begin();
+       it != symbols.end(); ++it) {
+    if (it->IsLocal()
+        && !it->IsFunction()
+        && it->GetCodeStart() <= cip && cip < it->GetCodeEnd()
+        && it->GetName() == name) {
+      symbol = *it;
+    }
+  }
+  if (!symbol) {
+    symbol = debug_info.GetStaticVariable(name);
+  }
+  if (!symbol) {
+    return false;
+  }
+
+  cell address = symbol.GetAddress();
+  if (symbol.IsLocal()) {
+    address += frm;
+  }
+  if (symbol.IsReference() || symbol.IsArrayRef()) {
+    address = *reinterpret_cast<cell*>(amx.GetData() + address);
+  }
+  if (address < 0 || address >= amx.GetStp()) {
+    return false;
+  }
+
+  const cell *data = reinterpret_cast<cell*>(amx.GetData() + address);
+  std::string tag_name = debug_info.GetTagName(symbol.GetTag());
+  AMXStackFramePrinter printer(stream, debug_info);
+
+  stream << name;
+  if (symbol.IsVariable() || symbol.IsReference()) {
+    stream << " = ";
+    printer.PrintValue(tag_name.c_str(), *data);
+  } else {
+    std::vector<AMXDebugSymbolDim> dims = symbol.GetDims();
+    for (std::size_t i = 0; i < dims.size(); i++) {
+      stream << "[" << dims[i].GetSize() << "]";
+    }
+    stream << " @ ";
+    printer.PrintAddress(address);
+
+    // Print the first few elements of one-dimensional arrays.
+    static const cell kMaxElements = 16;
+    if (dims.size() == 1) {
+      cell size = dims[0].GetSize();
+      stream << " = {";
+      cell available = (amx.GetStp() - address) / sizeof(cell);
+      for (cell i = 0; i < size && i < kMaxElements && i < available; i++) {
+        stream << (i > 0 ? ", " : "");
+        printer.PrintValue(tag_name.c_str(), data[i]);
+      }
+      stream << (size > kMaxElements ? ", ...}" : "}");
+    }
+  }
+  stream << "\n";
+  return true;
+}
+
+void Debugger::Reply(const std::string &text) {
+  socket_.Write(text + "ok\n");
+}
+
+void Debugger::ReplyError(const std::string &message) {
+  socket_.Write("error " + message + "\n");
+}
+
+// static
+Debugger &Debugger::shared() {
+  static Debugger instance;
+  return instance;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+#include "debugsocket.h"
+
+class CrashDetect;
+
+// A source-level debugger driven by a simple line-based text protocol over
+// a local socket. Each request is a single line and each reply ends with a
+// line that is either "ok" or "error <message>". When execution stops at a
+// breakpoint (or after a step) the debugger sends a "stopped ..." line and
+// blocks the server until the client tells it to continue.
+class Debugger {
+ public:
+  enum StepMode {
+    STEP_NONE,
+    STEP_INTO,
+    STEP_OVER,
+    STEP_OUT
+  };
+
+  bool Start(const std::string &path);
+  void Stop();
+
+  bool IsEnabled() const { return socket_.IsListening(); }
+
+  // Accepts a new client and processes its requests without blocking.
+  void Poll();
+
+  // Resolves the current breakpoints in a newly loaded script.
+  void OnLoad(CrashDetect *handler);
+
+  // Called from the debug hook of a script that is being stepped through;
+  // returns true if execution should stop at the current statement.
+  bool ShouldStep(AMX *amx, cell frm) const;
+
+  // Stops execution and handles requests until the client resumes it.
+  void Break(CrashDetect *handler, const char *reason);
+
+  static bool IsStepping() { return step_mode_ != STEP_NONE; }
+
+  static Debugger &shared();
+
+ private:
+  Debugger();
+
+  Debugger(const Debugger &);
+  Debugger &operator=(const Debugger &);
+
+  bool HandleRequest(const std::string &request, CrashDetect *handler);
+  void Detach();
+
+  void SetBreakpoint(CrashDetect *handler, const std::string &location);
+  int SetBreakpoint(const std::string &location);
+  int ClearBreakpoint(const std::string &location);
+
+  void PrintLocation(std::ostream &stream, CrashDetect *handler, cell cip);
+  void PrintLocals(std::ostream &stream,
+                   CrashDetect *handler,
+                   cell frm,
+                   cell cip);
+  bool PrintVariable(std::ostream &stream,
+                     CrashDetect *handler,
+                     const std::string &name,
+                     cell frm,
+                     cell cip);
+
+  void Reply(const std::string &text);
+  void ReplyError(const std::string &message);
+
+ private:
+  DebugSocket socket_;
+  std::vector<std::string> breakpoints_;
+  AMX *step_amx_;
+  cell step_frm_;
+
+  static StepMode step_mode_;
+};
+
+#endif // !DEBUGGER_H
@@ -0,0 +1,193 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "debugsocket.h"
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+bool SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+bool WaitFor(int fd, short events) {
+  pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = events;
+  pfd.revents = 0;
+  int result;
+  do {
+    result = poll(&pfd, 1, -1);
+  } while (result < 0 && errno == EINTR);
+  return result > 0;
+}
+
+} // anonymous namespace
+
+DebugSocket::DebugSocket()
+  : listen_fd_(-1),
+    client_fd_(-1)
+{
+}
+
+DebugSocket::~DebugSocket() {
+  Close();
+}
+
+bool DebugSocket::Listen(const std::string &path) {
+  sockaddr_un address;
+  if (path.length() >= sizeof(address.sun_path)) {
+    return false;
+  }
+
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Remove a stale socket left over from a previous run.
+  unlink(path.c_str());
+
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+      || chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0
+      || listen(fd, 1) != 0
+      || !SetNonBlocking(fd)) {
+    close(fd);
+    return false;
+  }
+
+  listen_fd_ = fd;
+  path_ = path;
+  return true;
+}
+
+void DebugSocket::Close() {
+  Disconnect();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    unlink(path_.c_str());
+    listen_fd_ = -1;
+  }
+}
+
+bool DebugSocket::Accept() {
+  if (client_fd_ >= 0) {
+    return true;
+  }
+  if (listen_fd_ < 0) {
+    return false;
+  }
+  int fd = accept(listen_fd_, nullptr, nullptr);
+  if (fd < 0) {
+    return false;
+  }
+  if (!SetNonBlocking(fd)) {
+    close(fd);
+    return false;
+  }
+  client_fd_ = fd;
+  buffer_.clear();
+  return true;
+}
+
+void DebugSocket::Disconnect() {
+  if (client_fd_ >= 0) {
+    close(client_fd_);
+    client_fd_ = -1;
+  }
+  buffer_.clear();
+}
+
+bool DebugSocket::ReadLine(std::string &line, bool wait) {
+  for (;;) {
+    std::string::size_type end = buffer_.find('\n');
+    if (end != std::string::npos) {
+      line.assign(buffer_, 0, end);
+      if (!line.empty() && line[line.length() - 1] == '\r') {
+        line.erase(line.length() - 1);
+      }
+      buffer_.erase(0, end + 1);
+      return true;
+    }
+
+    if (client_fd_ < 0) {
+      return false;
+    }
+
+    char data[512];
+    ssize_t count = recv(client_fd_, data, sizeof(data), 0);
+    if (count > 0) {
+      buffer_.append(data, count);
+      continue;
+    }
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (wait && WaitFor(client_fd_, POLLIN)) {
+        continue;
+      }
+      return false;
+    }
+
+    Disconnect();
+    return false;
+  }
+}
+
+bool DebugSocket::Write(const std::string &text) {
+  std::string::size_type offset = 0;
+  while (client_fd_ >= 0 && offset < text.length()) {
+    ssize_t count = send(client_fd_,
+                         text.data() + offset,
+                         text.length() - offset,
+                         MSG_NOSIGNAL);
+    if (count > 0) {
+      offset += count;
+    } else if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      WaitFor(client_fd_, POLLOUT);
+    } else {
+      Disconnect();
+    }
+  }
+  return client_fd_ >= 0;
+}
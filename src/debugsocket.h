@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef DEBUGSOCKET_H
+#define DEBUGSOCKET_H
+
+#include <string>
+
+// A local stream socket that accepts a single client at a time and exchanges
+// newline-terminated text with it. On Unix this is a Unix domain socket; other
+// platforms are not supported yet and Listen() always fails there.
+class DebugSocket {
+ public:
+  DebugSocket();
+  ~DebugSocket();
+
+  bool Listen(const std::string &path);
+  void Close();
+
+  bool IsListening() const { return listen_fd_ >= 0; }
+  bool IsConnected() const { return client_fd_ >= 0; }
+
+  // Accepts a pending connection if there is no client yet. Never blocks.
+  bool Accept();
+  void Disconnect();
+
+  // Reads a single line without the terminating newline. Returns false if
+  // there is no complete line available (and wait is false) or if the client
+  // has disconnected.
+  bool ReadLine(std::string &line, bool wait);
+  bool Write(const std::string &text);
+
+ private:
+  DebugSocket(const DebugSocket &);
+  DebugSocket &operator=(const DebugSocket &);
+
+ private:
+  int listen_fd_;
+  int client_fd_;
+  std::string path_;
+  std::string buffer_;
+};
+
+#endif // !DEBUGSOCKET_H
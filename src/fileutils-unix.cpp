@@ -27,8 +27,10 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fnmatch.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "fileutils.h"
 
@@ -64,4 +66,20 @@ std::string GetCurrentWorkingtDirectory() {
   return std::string(&buffer[0]);
 }
 
+bool MakeDirectory(const std::string &path) {
+  return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+std::FILE *OpenFileForReading(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  std::FILE *fp = fdopen(fd, "rb");
+  if (fp == nullptr) {
+    close(fd);
+  }
+  return fp;
+}
+
 } // namespace fileutils
@@ -27,6 +27,8 @@
 #endif
 #include <string>
 #include <vector>
+#include <fcntl.h>
+#include <io.h>
 #include <windows.h>
 #include "fileutils.h"
 
@@ -69,4 +71,21 @@ std::string GetCurrentWorkingtDirectory() {
   return std::string(&buffer[0]);
 }
 
+bool MakeDirectory(const std::string &path) {
+  return CreateDirectoryA(path.c_str(), nullptr) != FALSE
+      || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+std::FILE *OpenFileForReading(const std::string &path) {
+  int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  std::FILE *fp = _fdopen(fd, "rb");
+  if (fp == nullptr) {
+    _close(fd);
+  }
+  return fp;
+}
+
 } // namespace fileutils
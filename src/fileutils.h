@@ -25,6 +25,7 @@
 #ifndef FILEUTILS_H
 #define FILEUTILS_H
 
+#include <cstdio>
 #include <ctime>
 #include <string>
 #include <vector>
@@ -53,6 +54,14 @@ std::string GetRelativePath(std::string path, const std::string &dir);
 
 std::string GetCurrentWorkingtDirectory();
 
+// Returns true if the directory was created or already exists.
+bool MakeDirectory(const std::string &path);
+
+// Opens a file for reading in binary mode like fopen() does, but without
+// calling fopen() (or CreateFileA() on Windows) which the plugin hooks. Use
+// this from threads other than the main thread.
+std::FILE *OpenFileForReading(const std::string &path);
+
 } // namespace fileutils
 
 #endif // !FILEUTILS_H
@@ -0,0 +1,149 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include "formatbuffer.h"
+
+FormatBuffer::FormatBuffer(char *data, std::size_t size)
+  : data_(data),
+    size_(size),
+    length_(0),
+    truncated_(false)
+{
+  if (size_ > 0) {
+    data_[0] = '\0';
+  }
+}
+
+FormatBuffer::~FormatBuffer() {
+}
+
+void FormatBuffer::Clear() {
+  length_ = 0;
+  truncated_ = false;
+  if (size_ > 0) {
+    data_[0] = '\0';
+  }
+}
+
+FormatBuffer &FormatBuffer::Append(char c) {
+  return Append(&c, 1);
+}
+
+FormatBuffer &FormatBuffer::Append(const char *s) {
+  return Append(s, std::strlen(s));
+}
+
+FormatBuffer &FormatBuffer::Append(const char *s, std::size_t length) {
+  while (length > 0 && size_ > 0) {
+    // One byte is reserved for the terminating NUL.
+    std::size_t space = size_ - 1 - length_;
+    if (space == 0) {
+      Overflow();
+      space = size_ - 1 - length_;
+      if (space == 0) {
+        truncated_ = true;
+        break;
+      }
+    }
+    std::size_t count = length < space ? length : space;
+    std::memcpy(data_ + length_, s, count);
+    length_ += count;
+    data_[length_] = '\0';
+    s += count;
+    length -= count;
+  }
+  return *this;
+}
+
+FormatBuffer &FormatBuffer::AppendInt(long long value) {
+  if (value < 0) {
+    Append('-');
+    return AppendUInt(0ULL - static_cast<unsigned long long>(value));
+  }
+  return AppendUInt(static_cast<unsigned long long>(value));
+}
+
+FormatBuffer &FormatBuffer::AppendUInt(unsigned long long value) {
+  char digits[24];
+  std::size_t n = sizeof(digits);
+  do {
+    digits[--n] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return Append(digits + n, sizeof(digits) - n);
+}
+
+FormatBuffer &FormatBuffer::AppendHex(unsigned long long value, int width) {
+  static const char kDigits[] = "0123456789abcdef";
+  char digits[24];
+  std::size_t n = sizeof(digits);
+  do {
+    digits[--n] = kDigits[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+  for (int i = static_cast<int>(sizeof(digits) - n); i < width && n > 0; i++) {
+    digits[--n] = '0';
+  }
+  return Append(digits + n, sizeof(digits) - n);
+}
+
+FormatBuffer &FormatBuffer::AppendFixed(double value, int precision) {
+  char digits[64];
+  int length = std::snprintf(digits, sizeof(digits), "%.*f", precision, value);
+  if (length < 0) {
+    return *this;
+  }
+  if (static_cast<std::size_t>(length) >= sizeof(digits)) {
+    length = sizeof(digits) - 1;
+  }
+  return Append(digits, length);
+}
+
+void FormatBuffer::AppendNewLine() {
+  Append('\n');
+}
+
+StreamFormatBuffer::StreamFormatBuffer(std::ostream &stream)
+  : FormatBuffer(storage_, kSize),
+    stream_(stream)
+{
+}
+
+StreamFormatBuffer::~StreamFormatBuffer() {
+  Flush();
+}
+
+void StreamFormatBuffer::Flush() {
+  if (!IsEmpty()) {
+    stream_.write(c_str(), length());
+    Clear();
+  }
+}
+
+void StreamFormatBuffer::Overflow() {
+  Flush();
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FORMATBUFFER_H
+#define FORMATBUFFER_H
+
+#include <cstddef>
+#include <iosfwd>
+
+// Formats text into a fixed-size buffer provided by the caller. Nothing is
+// allocated, so this can be used where the heap is not usable (e.g. in a
+// crash handler). When the buffer is full Overflow() is called; unless a
+// subclass makes room, the rest of the output is dropped.
+class FormatBuffer {
+ public:
+  FormatBuffer(char *data, std::size_t size);
+  virtual ~FormatBuffer();
+
+  const char *c_str() const { return data_; }
+  std::size_t length() const { return length_; }
+  bool IsEmpty() const { return length_ == 0; }
+  bool IsTruncated() const { return truncated_; }
+
+  void Clear();
+
+  FormatBuffer &Append(char c);
+  FormatBuffer &Append(const char *s);
+  FormatBuffer &Append(const char *s, std::size_t length);
+  FormatBuffer &AppendInt(long long value);
+  FormatBuffer &AppendUInt(unsigned long long value);
+
+  // Lowercase, zero-padded to at least width digits.
+  FormatBuffer &AppendHex(unsigned long long value, int width);
+
+  // Same as printf("%.*f", precision, value).
+  FormatBuffer &AppendFixed(double value, int precision);
+
+  // Starts a new line. Subclasses may use this to output complete lines.
+  virtual void AppendNewLine();
+
+ protected:
+  virtual void Overflow() {}
+
+ private:
+  FormatBuffer(const FormatBuffer &);
+  FormatBuffer &operator=(const FormatBuffer &);
+
+ private:
+  char *data_;
+  std::size_t size_;
+  std::size_t length_;
+  bool truncated_;
+};
+
+// A FormatBuffer that writes its contents to a stream when it is full or
+// flushed.
+class StreamFormatBuffer: public FormatBuffer {
+ public:
+  explicit StreamFormatBuffer(std::ostream &stream);
+  ~StreamFormatBuffer();
+
+  void Flush();
+
+ protected:
+  void Overflow();
+
+ private:
+  static const std::size_t kSize = 1024;
+
+  std::ostream &stream_;
+  char storage_[kSize];
+};
+
+#endif // !FORMATBUFFER_H
@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "longcallprofile.h"
+
+namespace {
+
+long long ToMicroseconds(LongCallProfile::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+    .count();
+}
+
+} // anonymous namespace
+
+LongCallProfile::LongCallProfile()
+  : active_(false),
+    num_samples_(0)
+{
+}
+
+bool LongCallProfile::IsExpired(Clock::time_point now) const {
+  return now - start_time_ >= std::chrono::milliseconds(kMaxDurationMs);
+}
+
+void LongCallProfile::Start(Clock::time_point now) {
+  active_ = true;
+  start_time_ = now;
+  last_sample_time_ = now;
+  num_samples_ = 0;
+  stacks_.clear();
+}
+
+void LongCallProfile::Stop() {
+  active_ = false;
+}
+
+void LongCallProfile::AddSample(const std::string &stack,
+                                Clock::time_point now) {
+  stacks_[stack] += now - last_sample_time_;
+  last_sample_time_ = now;
+  num_samples_++;
+}
+
+void LongCallProfile::Print(std::ostream &stream,
+                            const std::string &function) const {
+  typedef std::pair<std::string, Clock::duration> Entry;
+  std::vector<Entry> entries(stacks_.begin(), stacks_.end());
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) {
+              return a.second > b.second;
+            });
+
+  long long total_time = ToMicroseconds(last_sample_time_ - start_time_);
+  stream << "Where the time went in " << function << " ("
+         << num_samples_ << " samples over " << total_time << " us):";
+
+  std::size_t num_printed =
+    std::min(entries.size(), static_cast<std::size_t>(kMaxPrintedStacks));
+  for (std::size_t i = 0; i < num_printed; i++) {
+    long long time = ToMicroseconds(entries[i].second);
+    stream << "\n" << time << " us";
+    if (total_time > 0) {
+      stream << " (" << time * 100 / total_time << "%)";
+    }
+    stream << " " << entries[i].first;
+  }
+  if (entries.size() > num_printed) {
+    stream << "\n... " << entries.size() - num_printed << " more stacks";
+  }
+}
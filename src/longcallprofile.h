@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LONGCALLPROFILE_H
+#define LONGCALLPROFILE_H
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+// Samples the call stack of a slow public call at the interpreter's long
+// call checkpoints and sums up the time between consecutive samples per
+// (collapsed) call stack.
+class LongCallProfile {
+ public:
+  typedef std::chrono::high_resolution_clock Clock;
+
+  // Sessions are stopped after this long even if the call is still running,
+  // e.g. if it's stuck in an infinite loop.
+  static const int kMaxDurationMs = 1000;
+
+  // At most this many stacks are printed, most expensive first.
+  static const int kMaxPrintedStacks = 20;
+
+  LongCallProfile();
+
+  bool IsActive() const { return active_; }
+  bool IsExpired(Clock::time_point now) const;
+
+  void Start(Clock::time_point now);
+  void Stop();
+
+  // Charges the time since the previous sample to the specified stack,
+  // which lists function names from the outermost to the innermost one,
+  // separated by semicolons.
+  void AddSample(const std::string &stack, Clock::time_point now);
+
+  void Print(std::ostream &stream, const std::string &function) const;
+
+ private:
+  bool active_;
+  Clock::time_point start_time_;
+  Clock::time_point last_sample_time_;
+  int num_samples_;
+  std::map<std::string, Clock::duration> stacks_;
+};
+
+#endif // !LONGCALLPROFILE_H
@@ -23,12 +23,27 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <sstream>
+#include <string>
+#include <vector>
 #include "crashdetect.h"
 #include "natives.h"
 #include "os.h"
+#include "tickprofiler.h"
 
 namespace {
 
+std::string GetStringParam(AMX *amx, cell string) {
+  cell *string_ptr;
+  int length;
+  if (amx_GetAddr(amx, string, &string_ptr) != AMX_ERR_NONE
+      || amx_StrLen(string_ptr, &length) != AMX_ERR_NONE) {
+    return std::string();
+  }
+  std::vector<char> buffer(length + 1);
+  amx_GetString(&buffer[0], string_ptr, 0, buffer.size());
+  return std::string(&buffer[0]);
+}
+
 // native PrintAmxBacktrace();
 cell AMX_NATIVE_CALL PrintBacktrace(AMX *amx, cell *params) {
   CrashDetect::PrintAMXBacktrace();
@@ -73,11 +88,139 @@ cell AMX_NATIVE_CALL GetNativeBacktrace(AMX *amx, cell *params) {
   return 0;
 }
 
+// native WatchVariable(const name[]);
+cell AMX_NATIVE_CALL WatchVariable(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  return CrashDetect::GetHandler(amx)->WatchVariable(name);
+}
+
+// native UnwatchVariable(const name[]);
+cell AMX_NATIVE_CALL UnwatchVariable(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  return CrashDetect::GetHandler(amx)->UnwatchVariable(name);
+}
+
+// native WatchAddress(address, cells = 1);
+cell AMX_NATIVE_CALL WatchAddress(AMX *amx, cell *params) {
+  cell address = params[1];
+  cell num_cells = params[2];
+  return CrashDetect::GetHandler(amx)->WatchAddress(address, num_cells);
+}
+
+// native UnwatchAddress(address);
+cell AMX_NATIVE_CALL UnwatchAddress(AMX *amx, cell *params) {
+  cell address = params[1];
+  return CrashDetect::GetHandler(amx)->UnwatchAddress(address);
+}
+
+// native TakeSnapshot();
+cell AMX_NATIVE_CALL TakeSnapshot(AMX *amx, cell *params) {
+  return CrashDetect::TakeSnapshot("TakeSnapshot() call");
+}
+
+// native SetLongCallBudget(const function[], us_time);
+cell AMX_NATIVE_CALL SetLongCallBudget(AMX *amx, cell *params) {
+  std::string pattern = GetStringParam(amx, params[1]);
+  cell time = params[2];
+  return CrashDetect::GetHandler(amx)->SetLongCallBudget(pattern, time);
+}
+
+// native GetLongCallBudget(const function[]);
+cell AMX_NATIVE_CALL GetLongCallBudget(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  return static_cast<cell>(
+    CrashDetect::GetHandler(amx)->GetLongCallBudget(name));
+}
+
+// native GetInstructionCount();
+cell AMX_NATIVE_CALL GetInstructionCount(AMX *amx, cell *params) {
+  return static_cast<cell>(CrashDetect::GetHandler(amx)->GetInstructionCount());
+}
+
+// native GetPublicInstructionCount(const function[]);
+cell AMX_NATIVE_CALL GetPublicInstructionCount(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  return static_cast<cell>(
+    CrashDetect::GetHandler(amx)->GetPublicInstructionCount(name));
+}
+
+// native GetFunctionInstructionCount(const function[]);
+cell AMX_NATIVE_CALL GetFunctionInstructionCount(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  return static_cast<cell>(
+    CrashDetect::GetHandler(amx)->GetFunctionInstructionCount(name));
+}
+
+// native ResetInstructionCounts();
+cell AMX_NATIVE_CALL ResetInstructionCounts(AMX *amx, cell *params) {
+  CrashDetect::GetHandler(amx)->ResetInstructionCounts();
+  return 1;
+}
+
+// native BenchmarkPublic(const function[], iterations, results[],
+//                        size = sizeof(results));
+cell AMX_NATIVE_CALL BenchmarkPublic(AMX *amx, cell *params) {
+  std::string name = GetStringParam(amx, params[1]);
+  cell iterations = params[2];
+  cell results = params[3];
+  cell size = params[4];
+
+  cell *results_ptr;
+  if (amx_GetAddr(amx, results, &results_ptr) != AMX_ERR_NONE) {
+    return 0;
+  }
+
+  CrashDetect::BenchmarkResult result;
+  if (CrashDetect::GetHandler(amx)->BenchmarkPublic(name,
+                                                    iterations,
+                                                    result)
+      != AMX_ERR_NONE) {
+    return 0;
+  }
+
+  const cell values[] = {
+    static_cast<cell>(result.min),
+    static_cast<cell>(result.median),
+    static_cast<cell>(result.p99),
+    static_cast<cell>(result.mean),
+    static_cast<cell>(result.num_outliers)
+  };
+  cell num_values = static_cast<cell>(sizeof(values) / sizeof(values[0]));
+  for (cell i = 0; i < size && i < num_values; i++) {
+    results_ptr[i] = values[i];
+  }
+  return result.num_samples;
+}
+
+// native GetLastTickTime();
+cell AMX_NATIVE_CALL GetLastTickTime(AMX *amx, cell *params) {
+  return static_cast<cell>(TickProfiler::shared().last_tick_time().count());
+}
+
+// native GetScriptTickTime();
+cell AMX_NATIVE_CALL GetScriptTickTime(AMX *amx, cell *params) {
+  return static_cast<cell>(TickProfiler::shared().GetLastTickTime(amx).count());
+}
+
 const AMX_NATIVE_INFO natives[] = {
   {"PrintBacktrace",       PrintBacktrace},
   {"PrintNativeBacktrace", PrintNativeBacktrace},
   {"GetBacktrace",         GetBacktrace},
   {"GetNativeBacktrace",   GetNativeBacktrace},
+  {"WatchVariable",        WatchVariable},
+  {"UnwatchVariable",      UnwatchVariable},
+  {"WatchAddress",         WatchAddress},
+  {"UnwatchAddress",       UnwatchAddress},
+  {"TakeSnapshot",         TakeSnapshot},
+  {"SetLongCallBudget",    SetLongCallBudget},
+  {"GetLongCallBudget",    GetLongCallBudget},
+  {"BenchmarkPublic",      BenchmarkPublic},
+  {"GetLastTickTime",      GetLastTickTime},
+  {"GetInstructionCount",  GetInstructionCount},
+  {"GetPublicInstructionCount", GetPublicInstructionCount},
+  {"GetFunctionInstructionCount", GetFunctionInstructionCount},
+  {"ResetInstructionCounts", ResetInstructionCounts},
+  {"GetScriptTickTime",    GetScriptTickTime},
   // Backwards compatibility:
   {"PrintAmxBacktrace",    PrintBacktrace},
   {"GetAmxBacktrace",      GetBacktrace}
@@ -22,6 +22,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <cstdlib>
 #include <configreader.h>
 #include "options.h"
 #include "regexp.h"
@@ -43,6 +44,44 @@ unsigned int TraceFlagsFromString(const std::string &s) {
   return flags;
 }
 
+unsigned int SnapshotFlagsFromStrings(const std::vector<std::string> &v) {
+  unsigned int flags = 0;
+  for (std::size_t i = 0; i < v.size(); i++) {
+    if (v[i] == "error") {
+      flags |= SNAPSHOT_ON_ERROR;
+    } else if (v[i] == "long_call") {
+      flags |= SNAPSHOT_ON_LONG_CALL;
+    }
+  }
+  return flags;
+}
+
+// Parses "[<script>:]<function>=<us>" entries.
+std::vector<LongCallBudget> LongCallBudgetsFromStrings(
+    const std::vector<std::string> &v) {
+  std::vector<LongCallBudget> budgets;
+  for (std::size_t i = 0; i < v.size(); i++) {
+    std::string::size_type equals = v[i].rfind('=');
+    if (equals == std::string::npos || equals + 1 == v[i].length()) {
+      continue;
+    }
+    LongCallBudget budget;
+    std::string name = v[i].substr(0, equals);
+    std::string::size_type colon = name.find(':');
+    if (colon != std::string::npos) {
+      budget.script = name.substr(0, colon);
+      budget.function = name.substr(colon + 1);
+    } else {
+      budget.script = "*";
+      budget.function = name;
+    }
+    budget.time = static_cast<unsigned int>(
+      std::strtoul(v[i].c_str() + equals + 1, nullptr, 10));
+    budgets.push_back(budget);
+  }
+  return budgets;
+}
+
 } // namespace
 
 Options::Options():
@@ -61,8 +100,31 @@ Options::Options():
   log_path_ = server_cfg.GetValueWithDefault("crashdetect_log");
   log_time_format_ =
     server_cfg.GetValueWithDefault("logtimeformat", "[%H:%M:%S]");
+  debug_socket_ = server_cfg.GetValueWithDefault("debug_socket");
+
+  snapshot_flags_ = SnapshotFlagsFromStrings(
+    server_cfg.GetValues<std::string>("snapshot_on"));
+  snapshot_dir_ = server_cfg.GetValueWithDefault("snapshot_dir", ".");
+  record_dir_ = server_cfg.GetValueWithDefault("record");
 
   long_call_time_ = server_cfg.GetValueWithDefault("long_call_time", 5000U);
+  long_call_budgets_ = LongCallBudgetsFromStrings(
+    server_cfg.GetValues<std::string>("long_call_budget"));
+  long_call_profile_ =
+    server_cfg.GetValueWithDefault("long_call_profile", 0U);
+  exec_history_ = server_cfg.GetValueWithDefault("exec_history", 0U);
+  watch_ = server_cfg.GetValues<std::string>("watch");
+  heap_profile_ = server_cfg.GetValueWithDefault("heap_profile", false);
+  count_instructions_ =
+    server_cfg.GetValueWithDefault("count_instructions", false);
+  instruction_report_dir_ =
+    server_cfg.GetValueWithDefault("instruction_report_dir");
+  stack_analysis_ = server_cfg.GetValueWithDefault("stack_analysis", false);
+  call_graph_dir_ = server_cfg.GetValueWithDefault("call_graph_dir");
+  tick_budget_ = server_cfg.GetValueWithDefault("tick_budget", 0U);
+  watchdog_timeout_ =
+    server_cfg.GetValueWithDefault("watchdog_timeout", 0U);
+  dump_signal_ = server_cfg.GetValueWithDefault("dump_signal", true);
 }
 
 Options::~Options() {
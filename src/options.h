@@ -26,6 +26,7 @@
 #define OPTIONS_H
 
 #include <string>
+#include <vector>
 
 class RegExp;
 
@@ -36,18 +37,63 @@ enum TraceFlags {
   TRACE_FUNCTIONS = 0x04
 };
 
+enum SnapshotFlags {
+  SNAPSHOT_NONE = 0x00,
+  SNAPSHOT_ON_ERROR = 0x01,
+  SNAPSHOT_ON_LONG_CALL = 0x02
+};
+
+// A long call time limit for the publics whose names match a pattern.
+struct LongCallBudget {
+  std::string script;
+  std::string function;
+  unsigned int time;
+};
+
 class Options {
  public:
   unsigned int trace_flags()
     const { return trace_flags_; }
   unsigned int long_call_time()
     const { return long_call_time_; }
+  const std::vector<LongCallBudget> &long_call_budgets()
+    const { return long_call_budgets_; }
+  unsigned int long_call_profile()
+    const { return long_call_profile_; }
+  unsigned int exec_history()
+    const { return exec_history_; }
+  const std::vector<std::string> &watch()
+    const { return watch_; }
+  bool heap_profile()
+    const { return heap_profile_; }
+  bool count_instructions()
+    const { return count_instructions_; }
+  const std::string &instruction_report_dir()
+    const { return instruction_report_dir_; }
+  bool stack_analysis()
+    const { return stack_analysis_; }
+  const std::string &call_graph_dir()
+    const { return call_graph_dir_; }
   const RegExp *trace_filter()
     const { return trace_filter_; }
   const std::string &log_path()
     const { return log_path_; }
   const std::string &log_time_format()
     const { return log_time_format_; }
+  const std::string &debug_socket()
+    const { return debug_socket_; }
+  unsigned int snapshot_flags()
+    const { return snapshot_flags_; }
+  const std::string &snapshot_dir()
+    const { return snapshot_dir_; }
+  const std::string &record_dir()
+    const { return record_dir_; }
+  unsigned int tick_budget()
+    const { return tick_budget_; }
+  unsigned int watchdog_timeout()
+    const { return watchdog_timeout_; }
+  bool dump_signal()
+    const { return dump_signal_; }
 
   static Options &shared();
 
@@ -60,9 +106,25 @@ class Options {
  private:
   unsigned int trace_flags_;
   unsigned int long_call_time_;
+  std::vector<LongCallBudget> long_call_budgets_;
+  unsigned int long_call_profile_;
+  unsigned int exec_history_;
+  std::vector<std::string> watch_;
+  bool heap_profile_;
+  bool count_instructions_;
+  std::string instruction_report_dir_;
+  bool stack_analysis_;
+  std::string call_graph_dir_;
   RegExp *trace_filter_;
   std::string log_path_;
   std::string log_time_format_;
+  std::string debug_socket_;
+  unsigned int snapshot_flags_;
+  std::string snapshot_dir_;
+  std::string record_dir_;
+  unsigned int tick_budget_;
+  unsigned int watchdog_timeout_;
+  bool dump_signal_;
 };
 
 #endif // !OPTIONS_H
@@ -22,13 +22,20 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <vector>
 #include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
 #include <link.h>
+#include <pthread.h>
 #include <signal.h>
 #include <ucontext.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "os.h"
 
 extern const char *__progname;
@@ -99,11 +106,12 @@ typedef void (*SignalHandler)(int signal, siginfo_t *info, void *context);
 
 void SetSignalHandler(int signal,
                      SignalHandler handler,
-                     struct sigaction *prev_action = nullptr) {
+                     struct sigaction *prev_action = nullptr,
+                     int flags = 0) {
   struct sigaction action;
   sigemptyset(&action.sa_mask);
   action.sa_sigaction = handler;
-  action.sa_flags = SA_SIGINFO;
+  action.sa_flags = SA_SIGINFO | flags;
   sigaction(signal, &action, prev_action);
 }
 
@@ -152,4 +160,131 @@ void SetInterruptHandler(InterruptHandler handler) {
   SetSignalHandler(SIGINT, HandleSIGINT, &prev_sigint_action);
 }
 
+namespace {
+
+ThreadDumpHandler thread_dump_handler = nullptr;
+pthread_t main_thread;
+
+// Filled in by the main thread in the SIGUSR2 handler and read by the thread
+// that called DumpMainThread() once dump_ready is set.
+const int kMaxDumpFrames = 100;
+ucontext_t dump_context;
+void *dump_stack[kMaxDumpFrames];
+int dump_stack_size;
+std::atomic<bool> dump_ready(false);
+
+// Only copies data: the main thread may have been interrupted while holding
+// a lock (e.g. in malloc()) that logging or symbolization would need.
+void HandleSIGUSR2(int signal, siginfo_t *info, void *context) {
+  assert(signal == SIGUSR2);
+  std::memcpy(&dump_context, context, sizeof(dump_context));
+  dump_stack_size = backtrace(dump_stack, kMaxDumpFrames);
+  dump_ready.store(true, std::memory_order_release);
+}
+
+} // namespace
+
+void SetThreadDumpHandler(ThreadDumpHandler handler) {
+  thread_dump_handler = handler;
+  main_thread = pthread_self();
+  // The first call to backtrace() loads libgcc, which allocates memory; get
+  // that out of the way before it's needed in the signal handler.
+  backtrace(dump_stack, 1);
+  // SA_RESTART: the main thread may be blocked in a system call (e.g. inside
+  // a database query) that must not fail with EINTR because of the dump.
+  SetSignalHandler(SIGUSR2, HandleSIGUSR2, nullptr, SA_RESTART);
+}
+
+bool DumpMainThread() {
+  if (thread_dump_handler == nullptr) {
+    return false;
+  }
+  dump_ready.store(false, std::memory_order_relaxed);
+  if (pthread_kill(main_thread, SIGUSR2) != 0) {
+    return false;
+  }
+  // Signals are handled as soon as the thread is scheduled, even if it's
+  // blocked in a system call; give up if that doesn't happen within a second.
+  for (int i = 0; i < 1000; i++) {
+    if (dump_ready.load(std::memory_order_acquire)) {
+      thread_dump_handler(Context(&dump_context), dump_stack, dump_stack_size);
+      return true;
+    }
+    usleep(1000);
+  }
+  return false;
+}
+
+namespace {
+
+DumpRequestHandler dump_request_handler = nullptr;
+
+void HandleSIGUSR1(int signal, siginfo_t *info, void *context) {
+  assert(signal == SIGUSR1);
+  if (dump_request_handler != nullptr) {
+    dump_request_handler();
+  }
+}
+
+// Async-signal-safe.
+void WriteFile(const FileData &file) {
+  int fd = open(file.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  const char *data = static_cast<const char*>(file.data);
+  std::size_t size = file.size;
+  while (size > 0) {
+    ssize_t count = write(fd, data, size);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    data += count;
+    size -= count;
+  }
+  close(fd);
+}
+
+} // namespace
+
+void SetDumpRequestHandler(DumpRequestHandler handler) {
+  dump_request_handler = handler;
+  SetSignalHandler(SIGUSR1, HandleSIGUSR1, nullptr, SA_RESTART);
+}
+
+bool WriteFilesInBackground(const std::vector<FileData> &files) {
+  pid_t pid = fork();
+  if (pid < 0) {
+    return false;
+  }
+  if (pid == 0) {
+    // Fork once more so that the actual worker is re-parented to init and the
+    // server doesn't have to reap it. The worker must not report its own
+    // crashes (or Ctrl+C) as if they happened in the server.
+    //
+    // Only async-signal-safe functions may be called from here on: any lock
+    // (e.g. of malloc() or of the log file) that another thread held at the
+    // time of fork() stays locked forever in the child.
+    if (fork() == 0) {
+      signal(SIGSEGV, SIG_DFL);
+      signal(SIGABRT, SIG_DFL);
+      signal(SIGINT, SIG_IGN);
+      signal(SIGUSR1, SIG_IGN);
+      signal(SIGUSR2, SIG_IGN);
+      for (std::size_t i = 0; i < files.size(); i++) {
+        WriteFile(files[i]);
+      }
+    }
+    _exit(0);
+  }
+  int status;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    // retry
+  }
+  return true;
+}
+
 } // namespace os
@@ -223,4 +223,107 @@ void SetInterruptHandler(InterruptHandler handler) {
   SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
 }
 
+namespace {
+
+ThreadDumpHandler thread_dump_handler = nullptr;
+DWORD main_thread_id = 0;
+ULONG_PTR main_stack_base = 0;
+
+// Filled in while the main thread is suspended and read after it has been
+// resumed.
+const int kMaxDumpFrames = 100;
+void *dump_stack[kMaxDumpFrames];
+
+// Copies the return addresses of a suspended thread by following its EBP
+// chain. Must not allocate or take any locks. Each frame must lie above the
+// previous one and below the base of the stack, which also ends the walk at
+// the first function that doesn't use EBP as the frame pointer.
+int GetFramePointerStack(const CONTEXT &context,
+                         void **stack,
+                         int max_size) {
+  int size = 0;
+  stack[size++] = reinterpret_cast<void*>(context.Eip);
+
+  ULONG_PTR frame = context.Ebp;
+  ULONG_PTR limit = context.Esp;
+  while (size < max_size
+         && frame >= limit
+         && frame % sizeof(ULONG_PTR) == 0
+         && frame + 2 * sizeof(ULONG_PTR) <= main_stack_base) {
+    const ULONG_PTR *frame_ptr = reinterpret_cast<const ULONG_PTR*>(frame);
+    if (frame_ptr[1] == 0) {
+      break;
+    }
+    stack[size++] = reinterpret_cast<void*>(frame_ptr[1]);
+    limit = frame + 2 * sizeof(ULONG_PTR);
+    frame = frame_ptr[0];
+  }
+  return size;
+}
+
+} // namespace
+
+void SetThreadDumpHandler(ThreadDumpHandler handler) {
+  thread_dump_handler = handler;
+  main_thread_id = GetCurrentThreadId();
+  // Everything between the stack pointer and the stack base is committed,
+  // so the frames can be read without probing.
+  NT_TIB *tib = reinterpret_cast<NT_TIB*>(NtCurrentTeb());
+  main_stack_base = reinterpret_cast<ULONG_PTR>(tib->StackBase);
+}
+
+bool DumpMainThread() {
+  if (thread_dump_handler == nullptr) {
+    return false;
+  }
+  HANDLE thread_handle = GetThreadHandle(main_thread_id,
+    THREAD_GET_CONTEXT | THREAD_SUSPEND_RESUME);
+  if (thread_handle == nullptr) {
+    return false;
+  }
+  bool ok = false;
+  int stack_size = 0;
+  CONTEXT context = {0};
+  context.ContextFlags = CONTEXT_FULL;
+  if (SuspendThread(thread_handle) != (DWORD)-1) {
+    ok = GetThreadContext(thread_handle, &context) != FALSE;
+    if (ok) {
+      stack_size = GetFramePointerStack(context, dump_stack, kMaxDumpFrames);
+    }
+    ResumeThread(thread_handle);
+  }
+  CloseHandle(thread_handle);
+  // The handler allocates and logs, so it must not run while the thread is
+  // suspended: it may have been holding the heap lock or the log's lock.
+  if (ok) {
+    thread_dump_handler(Context(&context), dump_stack, stack_size);
+  }
+  return ok;
+}
+
+namespace {
+
+DumpRequestHandler dump_request_handler = nullptr;
+
+BOOL WINAPI DumpRequestCtrlHandler(DWORD dwCtrlType) {
+  if (dwCtrlType == CTRL_BREAK_EVENT && dump_request_handler != nullptr) {
+    dump_request_handler();
+    // Handled: don't let the default handler terminate the process.
+    return TRUE;
+  }
+  return FALSE;
+}
+
+} // namespace
+
+void SetDumpRequestHandler(DumpRequestHandler handler) {
+  dump_request_handler = handler;
+  SetConsoleCtrlHandler(DumpRequestCtrlHandler, TRUE);
+}
+
+bool WriteFilesInBackground(const std::vector<FileData> &files) {
+  // There is no fork() on Windows.
+  return false;
+}
+
 } // namespace os
@@ -25,6 +25,7 @@
 #ifndef OS_H
 #define OS_H
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -47,6 +48,10 @@ class Context;
 
 typedef void (*CrashHandler)(const Context &context);
 typedef void (*InterruptHandler)(const Context &context);
+typedef void (*ThreadDumpHandler)(const Context &context,
+                                  void *const *stack,
+                                  int stack_size);
+typedef void (*DumpRequestHandler)();
 
 class Context {
  public:
@@ -111,6 +116,38 @@ std::string GetModuleName(void *address);
 void SetCrashHandler(CrashHandler handler);
 void SetInterruptHandler(InterruptHandler handler);
 
+// Sets the handler called by DumpMainThread(). Must be called from the main
+// thread.
+void SetThreadDumpHandler(ThreadDumpHandler handler);
+
+// Captures the context of the main thread and calls the thread dump handler
+// with it in the calling thread, after the main thread has been let go: it
+// may have been stopped while holding the heap lock or any other lock the
+// handler needs. On Unix the main thread receives SIGUSR2 and copies its
+// registers and return addresses (passed as stack) itself; system calls it
+// was blocked in are restarted afterwards. On Windows it is suspended just
+// long enough to read its registers and follow its frame pointer chain.
+// Returns false if the main thread can't be interrupted.
+bool DumpMainThread();
+
+// Sets the handler of external state dump requests: SIGUSR1 on Unix and
+// Ctrl+Break on Windows. Unlike the interrupt handler it doesn't terminate
+// the server. The handler runs asynchronously (in a signal handler or in
+// another thread), so it should do nothing more than record the request.
+void SetDumpRequestHandler(DumpRequestHandler handler);
+
+struct FileData {
+  std::string path;
+  const void *data;
+  std::size_t size;
+};
+
+// Writes the files in a copy-on-write clone of the current process, so the
+// data is saved as it was at the time of the call, and returns as soon as the
+// clone has been created. Returns false if this is not supported by the OS or
+// the clone could not be created.
+bool WriteFilesInBackground(const std::vector<FileData> &files);
+
 } // namespace os
 
 #endif // !OS_H
@@ -30,7 +30,11 @@
   #include <stdio.h>
 #endif
 #include <subhook.h>
+#include "amxcallgraph.h"
+#include "amxdebuginfoprefetcher.h"
 #include "amxpathfinder.h"
+#include "amxsymbolindex.h"
+#include "amxstatetable.h"
 #include "crashdetect.h"
 #include "fileutils.h"
 #include "logprintf.h"
@@ -46,6 +50,8 @@ namespace {
 std::vector<std::function<void()>> unload_callbacks;
 
 subhook::Hook exec_hook;
+subhook::Hook allot_hook;
+subhook::Hook release_hook;
 subhook::Hook open_file_hook;
 std::string last_opened_amx_file_name;
 
@@ -104,6 +110,18 @@ int AMXAPI OnExec(AMX *amx, cell *retval, int index) {
   return handler->OnExec(retval, index);
 }
 
+// The server and other plugins allocate the arguments of public functions
+// with the exported amx_Allot() (via amx_PushArray() and amx_PushString())
+// and free them with amx_Release(). Our copies report these heap changes to
+// the heap profiler.
+int AMXAPI OnAllot(AMX *amx, int cells, cell *amx_addr, cell **phys_addr) {
+  return amx_Allot(amx, cells, amx_addr, phys_addr);
+}
+
+int AMXAPI OnRelease(AMX *amx, cell amx_addr) {
+  return amx_Release(amx, amx_addr);
+}
+
 int AMXAPI OnExecError(AMX *amx, cell index, cell *retval, int error) {
   CrashDetect *handler = CrashDetect::GetHandler(amx);
   return handler->OnExecError(index, retval, error);
@@ -119,10 +137,25 @@ int AMXAPI OnAddressNaughtRequest(AMX *amx, int option) {
   return handler->OnAddressNaughtRequest(option);
 }
 
+int AMXAPI OnWatch(AMX *amx, cell address, cell size) {
+  CrashDetect *handler = CrashDetect::GetHandler(amx);
+  return handler->OnWatch(address, size);
+}
+
+int AMXAPI OnHeapChange(AMX *amx, cell cip, cell from, cell to) {
+  CrashDetect *handler = CrashDetect::GetHandler(amx);
+  return handler->OnHeapChange(cip, from, to);
+}
+
+int AMXAPI OnMeterEvent(AMX *amx, int event, cell cip) {
+  CrashDetect *handler = CrashDetect::GetHandler(amx);
+  return handler->OnMeterEvent(event, cip);
+}
+
 } // anonymous namespace
 
 PLUGIN_EXPORT unsigned int PLUGIN_CALL Supports() {
-  return SUPPORTS_VERSION | SUPPORTS_AMX_NATIVES;
+  return SUPPORTS_VERSION | SUPPORTS_AMX_NATIVES | SUPPORTS_PROCESS_TICK;
 }
 
 PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData) {
@@ -146,6 +179,15 @@ PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData) {
     return false;
   }
 
+  if (Options::shared().heap_profile()) {
+    allot_hook.Install(exports[PLUGIN_AMX_EXPORT_Allot], (void*)OnAllot);
+    release_hook.Install(exports[PLUGIN_AMX_EXPORT_Release], (void*)OnRelease);
+    unload_callbacks.push_back([]() {
+      allot_hook.Remove();
+      release_hook.Remove();
+    });
+  }
+
   #if _WIN32
     open_file_hook.Install((void*)CreateFileA, (void*)CreateFileAHook);
   #else
@@ -167,6 +209,12 @@ PLUGIN_EXPORT bool PLUGIN_CALL Load(void **ppData) {
                    &AMXPathFinder::shared()));
   }
 
+  AMXDebugInfoPrefetcher::shared().Start(
+    AMXPathFinder::shared().search_paths());
+  unload_callbacks.push_back([]() {
+    AMXDebugInfoPrefetcher::shared().Stop();
+  });
+
   os::SetCrashHandler(CrashDetect::OnCrash);
   os::SetInterruptHandler(CrashDetect::OnInterrupt);
   CrashDetect::PluginLoad();
@@ -183,23 +231,44 @@ PLUGIN_EXPORT void PLUGIN_CALL Unload() {
   }
 }
 
+PLUGIN_EXPORT void PLUGIN_CALL ProcessTick() {
+  // The gamemode and the filterscripts are loaded before the first tick.
+  static bool first_tick = true;
+  if (first_tick) {
+    first_tick = false;
+    AMXDebugInfoPrefetcher::shared().Discard();
+  }
+  CrashDetect::ProcessTick();
+}
+
 PLUGIN_EXPORT int PLUGIN_CALL AmxLoad(AMX *amx) {
   if (!last_opened_amx_file_name.empty()) {
     AMXPathFinder::shared().AddKnownFile(amx, last_opened_amx_file_name);
   }
 
+  AMXStateTables::CreateHandler(amx);
+  AMXCallGraphs::CreateHandler(amx);
+  AMXSymbolIndex::CreateHandler(amx);
+
   CrashDetect *handler = CrashDetect::CreateHandler(amx);
+  handler->watch()->callback = OnWatch;
   handler->Load();
 
   amx_SetDebugHook(amx, OnDebugHook);
   amx_SetCallback(amx, OnCallback);
 
-  static AMX_EXT_HOOKS ext_hooks = {
-    OnExecError,
-    OnLongCallRequest,
-    OnAddressNaughtRequest
-  };
-  amx_SetExtHooks(amx, &ext_hooks);
+  AMX_EXT_HOOKS *ext_hooks = handler->ext_hooks();
+  ext_hooks->exec_error = OnExecError;
+  ext_hooks->long_call_ctl = OnLongCallRequest;
+  ext_hooks->address_naught_ctl = OnAddressNaughtRequest;
+  if (Options::shared().heap_profile()) {
+    ext_hooks->heap_ctl = OnHeapChange;
+  }
+  if (Options::shared().count_instructions()) {
+    handler->meter()->callback = OnMeterEvent;
+    ext_hooks->meter = handler->meter();
+  }
+  amx_SetExtHooks(amx, ext_hooks);
 
   RegisterNatives(amx);
   return AMX_ERR_NONE;
@@ -208,5 +277,8 @@ PLUGIN_EXPORT int PLUGIN_CALL AmxLoad(AMX *amx) {
 PLUGIN_EXPORT int PLUGIN_CALL AmxUnload(AMX *amx) {
   CrashDetect::GetHandler(amx)->Unload();
   CrashDetect::DestroyHandler(amx);
+  AMXStateTables::DestroyHandler(amx);
+  AMXCallGraphs::DestroyHandler(amx);
+  AMXSymbolIndex::DestroyHandler(amx);
   return AMX_ERR_NONE;
 }
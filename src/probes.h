@@ -0,0 +1,52 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PROBES_H
+#define PROBES_H
+
+// USDT probes for bpftrace, perf and SystemTap. Each probe is a single NOP
+// until a tracer attaches to it. Without sys/sdt.h the probes compile to
+// nothing.
+//
+//   public_entry(amx, index, cip)
+//   public_return(amx, index, cip, error)
+//   native_entry(amx, index, cip)
+//   native_return(amx, index, cip, error)
+//   exec_error(amx, index, cip, error)
+//   long_call(amx, index, cip, budget_us)
+//
+// See tools/bpftrace for example scripts.
+
+#if defined HAVE_SYS_SDT_H
+  #include <sys/sdt.h>
+  #define CRASHDETECT_PROBE3(name, arg1, arg2, arg3) \
+    DTRACE_PROBE3(crashdetect, name, arg1, arg2, arg3)
+  #define CRASHDETECT_PROBE4(name, arg1, arg2, arg3, arg4) \
+    DTRACE_PROBE4(crashdetect, name, arg1, arg2, arg3, arg4)
+#else
+  #define CRASHDETECT_PROBE3(name, arg1, arg2, arg3)
+  #define CRASHDETECT_PROBE4(name, arg1, arg2, arg3, arg4)
+#endif
+
+#endif // !PROBES_H
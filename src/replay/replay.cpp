@@ -0,0 +1,244 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Replays a recording made with the "record" option: loads the script, runs
+// the recorded public calls through amx_Exec() and answers native calls from
+// the log instead of calling the real natives. Any difference between the
+// recorded and the actual course of execution is reported.
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <amx/amx.h>
+#include <amx/amxaux.h>
+#include "amxrecording.h"
+
+using namespace amxrecording;
+
+namespace {
+
+AMXRecordingReader reader;
+int num_publics = 0;
+int num_natives = 0;
+int num_mismatches = 0;
+bool failed = false;
+
+void ReportMismatch(const char *format, ...) {
+  std::va_list args;
+  va_start(args, format);
+  std::fprintf(stderr, "Mismatch: ");
+  std::vfprintf(stderr, format, args);
+  std::fprintf(stderr, "\n");
+  va_end(args);
+  num_mismatches++;
+}
+
+cell *GetData(AMX *amx) {
+  unsigned char *data = amx->data;
+  if (data == nullptr) {
+    data = amx->base + reinterpret_cast<AMX_HEADER*>(amx->base)->dat;
+  }
+  return reinterpret_cast<cell*>(data);
+}
+
+std::string GetPublicName(AMX *amx, cell index) {
+  char name[sNAMEMAX + 1];
+  if (index == AMX_EXEC_MAIN) {
+    return "main";
+  }
+  if (amx_GetPublic(amx, index, name) != AMX_ERR_NONE) {
+    return "<unknown>";
+  }
+  return name;
+}
+
+std::string GetNativeName(AMX *amx, cell index) {
+  char name[sNAMEMAX + 1];
+  if (amx_GetNative(amx, index, name) != AMX_ERR_NONE) {
+    return "<unknown>";
+  }
+  return name;
+}
+
+cell AMX_NATIVE_CALL DummyNative(AMX *amx, cell *params) {
+  return 0;
+}
+
+bool ReadUntil(AMX *amx, RecordType type, Record &record);
+
+void ReplayPublic(AMX *amx, const Record &call) {
+  cell *data = GetData(amx);
+  cell hea = amx->hea;
+
+  // String and array arguments are allocated on the heap.
+  if (!call.heap.empty()) {
+    std::memcpy(data + amx->hlw / sizeof(cell),
+                &call.heap[0],
+                call.heap.size() * sizeof(cell));
+  }
+  amx->hea = call.hea;
+  for (std::size_t i = call.args.size(); i-- > 0; ) {
+    amx_Push(amx, call.args[i]);
+  }
+  if (amx->stk != call.stk) {
+    ReportMismatch("stack pointer is %08X instead of %08X when calling %s",
+                   amx->stk, call.stk, GetPublicName(amx, call.index).c_str());
+  }
+
+  num_publics++;
+  cell retval = 0;
+  int error = amx_Exec(amx, &retval, call.index);
+  amx->hea = hea;
+
+  Record result;
+  if (!ReadUntil(amx, PUBLIC_RETURN, result)) {
+    return;
+  }
+  if (result.index != call.index) {
+    ReportMismatch("%s returned instead of %s",
+                   GetPublicName(amx, call.index).c_str(),
+                   GetPublicName(amx, result.index).c_str());
+  } else if (error != result.error) {
+    ReportMismatch("%s failed with error %d (%s) instead of %d",
+                   GetPublicName(amx, call.index).c_str(),
+                   error, aux_StrError(error), result.error);
+  } else if (retval != result.retval) {
+    ReportMismatch("%s returned %d instead of %d",
+                   GetPublicName(amx, call.index).c_str(),
+                   retval, result.retval);
+  }
+}
+
+// Reads the next record of the given type, replaying any public calls that
+// were made before it (e.g. by a native function).
+bool ReadUntil(AMX *amx, RecordType type, Record &record) {
+  while (!failed) {
+    if (!reader.Read(record)) {
+      std::fprintf(stderr, "Unexpected end of recording\n");
+      failed = true;
+      break;
+    }
+    if (record.type == PUBLIC_CALL) {
+      Record call = record;
+      ReplayPublic(amx, call);
+      continue;
+    }
+    if (record.type == type) {
+      return true;
+    }
+    ReportMismatch("execution took a different path than recorded");
+    failed = true;
+  }
+  return false;
+}
+
+int AMXAPI ReplayCallback(AMX *amx, cell index, cell *result, cell *params) {
+  Record record;
+  if (!ReadUntil(amx, NATIVE_RETURN, record)) {
+    return AMX_ERR_CALLBACK;
+  }
+  if (record.index != index) {
+    ReportMismatch("called native %s instead of %s",
+                   GetNativeName(amx, index).c_str(),
+                   GetNativeName(amx, record.index).c_str());
+  }
+
+  cell *data = GetData(amx);
+  for (std::vector<Block>::const_iterator it = record.blocks.begin();
+       it != record.blocks.end(); it++) {
+    if (!it->cells.empty()) {
+      std::memcpy(data + it->address / sizeof(cell),
+                  &it->cells[0],
+                  it->cells.size() * sizeof(cell));
+    }
+  }
+
+  num_natives++;
+  *result = record.retval;
+  return record.error;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::fprintf(stderr, "Usage: %s <script.amx> <script.rec>\n", argv[0]);
+    return 2;
+  }
+
+  AMX amx;
+  int error = aux_LoadProgram(&amx, argv[1], nullptr);
+  if (error != AMX_ERR_NONE) {
+    std::fprintf(stderr, "Could not load %s: %s\n",
+                 argv[1], aux_StrError(error));
+    return 2;
+  }
+
+  // The natives are never called, but amx_Exec() refuses to run a script
+  // whose natives are not registered.
+  int num_natives_total = 0;
+  amx_NumNatives(&amx, &num_natives_total);
+  std::vector<std::string> names(num_natives_total);
+  std::vector<AMX_NATIVE_INFO> natives(num_natives_total);
+  for (int i = 0; i < num_natives_total; i++) {
+    names[i] = GetNativeName(&amx, i);
+    natives[i].name = names[i].c_str();
+    natives[i].func = DummyNative;
+  }
+  if (num_natives_total > 0) {
+    amx_Register(&amx, &natives[0], num_natives_total);
+  }
+  amx_SetCallback(&amx, ReplayCallback);
+
+  if (!reader.Open(argv[2], &amx)) {
+    std::fprintf(stderr, "%s is not a recording of %s\n", argv[2], argv[1]);
+    aux_FreeProgram(&amx);
+    return 2;
+  }
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  Record record;
+  while (!failed && reader.Read(record)) {
+    if (record.type != PUBLIC_CALL) {
+      ReportMismatch("expected a public call");
+      break;
+    }
+    ReplayPublic(&amx, record);
+  }
+
+  std::chrono::duration<double, std::milli> duration =
+    std::chrono::steady_clock::now() - start;
+  std::printf("Replayed %d public and %d native calls in %.3f ms, "
+              "%d mismatches\n",
+              num_publics, num_natives, duration.count(), num_mismatches);
+
+  reader.Close();
+  aux_FreeProgram(&amx);
+  return num_mismatches == 0 && !failed ? 0 : 1;
+}
@@ -22,6 +22,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <cstdlib>
 #include <string>
 #include <execinfo.h>
 
@@ -48,14 +49,21 @@ void GetStackTrace(std::vector<StackFrame> &frames, void *context) {
   void *trace[kMaxFrames];
 
   int length = backtrace(trace, kMaxFrames);
-  char **symbols = backtrace_symbols(trace, length);
+  GetStackTrace(frames, trace, length);
+}
+
+void GetStackTrace(std::vector<StackFrame> &frames,
+                   void *const *addresses,
+                   int num_addresses) {
+  char **symbols = backtrace_symbols(addresses, num_addresses);
 
-  for (int i = 0; i < length; i++) {
-    if (symbols[i] != 0) {
+  for (int i = 0; i < num_addresses; i++) {
+    if (symbols != 0 && symbols[i] != 0) {
       std::string name = GetSymbolName(symbols[i]);
-      frames.push_back(StackFrame(trace[i], name));
+      frames.push_back(StackFrame(addresses[i], name));
     } else {
-      frames.push_back(StackFrame(trace[i]));
+      frames.push_back(StackFrame(addresses[i]));
     }
   }
+  std::free(symbols);
 }
@@ -233,3 +233,32 @@ void GetStackTrace(std::vector<StackFrame> &frames, void *context_ptr) {
   HeapFree(GetProcessHeap(), 0, symbol);
   dbghelp.SymCleanup(process);
 }
+
+void GetStackTrace(std::vector<StackFrame> &frames,
+                   void *const *addresses,
+                   int num_addresses) {
+  HANDLE process = GetCurrentProcess();
+  DbgHelp dbghelp(process);
+
+  SIZE_T size = sizeof(SYMBOL_INFO) + kMaxSymbolNameLength + 1;
+  SYMBOL_INFO *symbol = static_cast<SYMBOL_INFO*>(
+    HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size));
+  if (symbol != nullptr) {
+    symbol->SizeOfStruct = sizeof(*symbol);
+    symbol->MaxNameLen = kMaxSymbolNameLength;
+  }
+
+  for (int i = 0; i < num_addresses; i++) {
+    DWORD64 address = reinterpret_cast<DWORD64>(addresses[i]);
+    const char *name = "";
+    if (dbghelp.is_initialized()
+        && dbghelp.SymFromAddr != nullptr
+        && symbol != nullptr
+        && dbghelp.SymFromAddr(process, address, nullptr, symbol)) {
+      name = symbol->Name;
+    }
+    frames.push_back(StackFrame(addresses[i], name));
+  }
+
+  HeapFree(GetProcessHeap(), 0, symbol);
+}
@@ -45,4 +45,10 @@ class StackFrame {
 
 void GetStackTrace(std::vector<StackFrame> &frames, void *context);
 
+// Looks up the names of return addresses that were captured earlier, e.g.
+// by a signal handler which can't do it itself.
+void GetStackTrace(std::vector<StackFrame> &frames,
+                   void *const *addresses,
+                   int num_addresses);
+
 #endif // !STACKTRACE_H
@@ -75,4 +75,29 @@ int CompareIgnoreCase(const std::string &s1, const std::string &s2) {
   return CompareIgnoreCase(s1.c_str(), s2.c_str());
 }
 
+bool MatchWildcard(const char *pattern, const char *s) {
+  // Backtrack to the last '*' on mismatch; that is enough because a later
+  // '*' can always absorb whatever an earlier one would have.
+  const char *star = nullptr;
+  const char *star_s = nullptr;
+  while (*s != '\0') {
+    if (*pattern == '*') {
+      star = pattern++;
+      star_s = s;
+    } else if (*pattern == '?' || *pattern == *s) {
+      pattern++;
+      s++;
+    } else if (star != nullptr) {
+      pattern = star + 1;
+      s = ++star_s;
+    } else {
+      return false;
+    }
+  }
+  while (*pattern == '*') {
+    pattern++;
+  }
+  return *pattern == '\0';
+}
+
 } // namespace stringutils
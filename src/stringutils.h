@@ -54,6 +54,10 @@ std::string ToUpper(const std::string &s);
 int CompareIgnoreCase(const char *s1, const char *s2);
 int CompareIgnoreCase(const std::string &s1, const std::string &s2);
 
+// Matches a string against a pattern where '*' stands for any sequence of
+// characters and '?' for any single character.
+bool MatchWildcard(const char *pattern, const char *s);
+
 } // namespace stringutils
 
 #endif // !STRINGUTILS_H
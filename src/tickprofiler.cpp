@@ -0,0 +1,274 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include "tickprofiler.h"
+
+namespace {
+
+long long ToMicroseconds(TickProfiler::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+    .count();
+}
+
+} // anonymous namespace
+
+TickProfiler::TickProfiler()
+  : budget_(0),
+    last_tick_time_(0),
+    histogram_(),
+    num_ticks_(0),
+    num_ticks_over_budget_(0)
+{
+}
+
+TickProfiler::Script::Script(AMXRef amx)
+  : amx(amx),
+    time(Clock::duration::zero()),
+    last_tick_time(Clock::duration::zero())
+{
+}
+
+void TickProfiler::Start(std::chrono::microseconds budget) {
+  budget_ = budget;
+  main_thread_id_ = std::this_thread::get_id();
+  last_event_time_ = Clock::now();
+}
+
+bool TickProfiler::IsMainThread() const {
+  return std::this_thread::get_id() == main_thread_id_;
+}
+
+void TickProfiler::AddScript(AMXRef amx, const std::string &name) {
+  std::unique_ptr<Script> script(new Script(amx));
+  script->name = name;
+  script->publics.resize(amx.GetNumPublics() + 2);
+  for (std::size_t i = 0; i < script->publics.size(); i++) {
+    Counter &counter = script->publics[i];
+    counter.script = script.get();
+    counter.index = static_cast<int>(i) - 2;
+    counter.time = Clock::duration::zero();
+    counter.inclusive_time = Clock::duration::zero();
+    counter.num_calls = 0;
+    counter.depth = 0;
+  }
+  scripts_[amx.amx()] = std::move(script);
+}
+
+void TickProfiler::RemoveScript(AMXRef amx) {
+  auto iterator = scripts_.find(amx.amx());
+  if (iterator == scripts_.end()) {
+    return;
+  }
+  const Script *script = iterator->second.get();
+  auto belongs_to_script = [script](const Counter *counter) {
+    return counter->script == script;
+  };
+  touched_.erase(std::remove_if(touched_.begin(), touched_.end(),
+                                belongs_to_script),
+                 touched_.end());
+  last_report_.erase(
+    std::remove_if(last_report_.begin(), last_report_.end(),
+                   [script](const ReportEntry &entry) {
+                     return entry.script == script;
+                   }),
+    last_report_.end());
+  scripts_.erase(iterator);
+}
+
+void TickProfiler::ChargeCurrent(Clock::time_point now) {
+  if (!active_.empty()) {
+    Counter *counter = active_.back().counter;
+    Clock::duration elapsed = now - last_event_time_;
+    counter->time += elapsed;
+    counter->script->time += elapsed;
+  }
+  last_event_time_ = now;
+}
+
+bool TickProfiler::BeginPublic(AMXRef amx, int index) {
+  if (!IsMainThread()) {
+    return false;
+  }
+  auto iterator = scripts_.find(amx.amx());
+  if (iterator == scripts_.end()) {
+    return false;
+  }
+  Script *script = iterator->second.get();
+  std::size_t slot = static_cast<std::size_t>(index + 2);
+  if (slot >= script->publics.size()) {
+    return false;
+  }
+
+  Clock::time_point now = Clock::now();
+  ChargeCurrent(now);
+
+  Counter *counter = &script->publics[slot];
+  if (counter->num_calls++ == 0) {
+    touched_.push_back(counter);
+  }
+  counter->depth++;
+  Activation activation = {counter, now};
+  active_.push_back(activation);
+  return true;
+}
+
+void TickProfiler::EndPublic() {
+  assert(IsMainThread() && !active_.empty());
+  Clock::time_point now = Clock::now();
+  ChargeCurrent(now);
+
+  Activation activation = active_.back();
+  active_.pop_back();
+  if (--activation.counter->depth == 0) {
+    activation.counter->inclusive_time += now - activation.start_time;
+  }
+}
+
+bool TickProfiler::EndTick() {
+  if (!active_.empty()) {
+    // ProcessTick() is not called from inside a script, but just in case.
+    return false;
+  }
+  last_event_time_ = Clock::now();
+
+  Clock::duration total_time = Clock::duration::zero();
+  for (auto &pair : scripts_) {
+    Script *script = pair.second.get();
+    script->last_tick_time = script->time;
+    script->time = Clock::duration::zero();
+    total_time += script->last_tick_time;
+  }
+  last_tick_time_ =
+    std::chrono::duration_cast<std::chrono::microseconds>(total_time);
+
+  int bucket = 0;
+  for (long long us = last_tick_time_.count();
+       us > 0 && bucket < kNumHistogramBuckets - 1;
+       us >>= 1) {
+    bucket++;
+  }
+  histogram_[bucket]++;
+  num_ticks_++;
+
+  bool over_budget = last_tick_time_ > budget_;
+  if (over_budget) {
+    num_ticks_over_budget_++;
+    last_report_.clear();
+    for (std::size_t i = 0; i < touched_.size(); i++) {
+      const Counter *counter = touched_[i];
+      ReportEntry entry;
+      entry.script = counter->script;
+      entry.index = counter->index;
+      entry.time = counter->time;
+      entry.inclusive_time = counter->inclusive_time;
+      entry.num_calls = counter->num_calls;
+      last_report_.push_back(entry);
+    }
+    std::sort(last_report_.begin(), last_report_.end(),
+              [](const ReportEntry &a, const ReportEntry &b) {
+                return a.time > b.time;
+              });
+  }
+
+  for (std::size_t i = 0; i < touched_.size(); i++) {
+    touched_[i]->time = Clock::duration::zero();
+    touched_[i]->inclusive_time = Clock::duration::zero();
+    touched_[i]->num_calls = 0;
+    touched_[i]->depth = 0;
+  }
+  touched_.clear();
+
+  return over_budget;
+}
+
+std::chrono::microseconds TickProfiler::GetLastTickTime(AMXRef amx) const {
+  auto iterator = scripts_.find(amx.amx());
+  if (iterator == scripts_.end()) {
+    return std::chrono::microseconds(0);
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    iterator->second->last_tick_time);
+}
+
+void TickProfiler::PrintReport(std::ostream &stream) const {
+  stream << "Tick went over budget: " << last_tick_time_.count()
+         << " us spent in scripts, budget is " << budget_.count() << " us";
+
+  for (auto &pair : scripts_) {
+    const Script *script = pair.second.get();
+    if (script->last_tick_time == Clock::duration::zero()) {
+      continue;
+    }
+    stream << "\n" << script->name << ": "
+           << ToMicroseconds(script->last_tick_time) << " us";
+    for (std::size_t i = 0; i < last_report_.size(); i++) {
+      const ReportEntry &entry = last_report_[i];
+      if (entry.script != script) {
+        continue;
+      }
+      const char *name;
+      if (entry.index == AMX_EXEC_MAIN) {
+        name = "main";
+      } else if (entry.index == AMX_EXEC_CONT) {
+        name = "<continued>";
+      } else {
+        name = script->amx.GetPublicName(entry.index);
+      }
+      stream << "\n  " << (name != nullptr ? name : "<unknown>") << ": "
+             << ToMicroseconds(entry.time) << " us in "
+             << entry.num_calls << (entry.num_calls == 1 ? " call" : " calls");
+      if (entry.inclusive_time > entry.time) {
+        stream << ", " << ToMicroseconds(entry.inclusive_time)
+               << " us including publics it called";
+      }
+    }
+  }
+}
+
+void TickProfiler::PrintHistogram(std::ostream &stream) const {
+  stream << "Script time per tick (" << num_ticks_ << " ticks, "
+         << num_ticks_over_budget_ << " over budget):";
+  for (int i = 0; i < kNumHistogramBuckets; i++) {
+    if (histogram_[i] == 0) {
+      continue;
+    }
+    long long low = (i == 0) ? 0 : (1LL << (i - 1));
+    stream << "\n  " << low << " us";
+    if (i < kNumHistogramBuckets - 1) {
+      stream << " - " << (1LL << i) - 1 << " us";
+    } else {
+      stream << " and more";
+    }
+    stream << ": " << histogram_[i];
+  }
+}
+
+// static
+TickProfiler &TickProfiler::shared() {
+  static TickProfiler instance;
+  return instance;
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TICKPROFILER_H
+#define TICKPROFILER_H
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <amx/amx.h>
+#include "amxref.h"
+
+// Measures how much of each server tick is spent in each script and public
+// function. Time is charged to the innermost public function that is being
+// executed on the main thread, including the natives it calls but not the
+// publics of other scripts that those natives call in turn. The inclusive
+// time of each public, which does count those (e.g. filterscript publics
+// called through CallRemoteFunction), is tracked as well.
+class TickProfiler {
+ public:
+  typedef std::chrono::high_resolution_clock Clock;
+
+  // Bucket n > 0 counts ticks of [2^(n-1), 2^n) microseconds and bucket 0
+  // those under a microsecond. The last bucket also counts longer ticks.
+  static const int kNumHistogramBuckets = 24;
+
+  bool IsEnabled() const { return budget_.count() != 0; }
+
+  // Enables profiling of the current thread. Ticks in which scripts run for
+  // longer than the budget are reported by EndTick().
+  void Start(std::chrono::microseconds budget);
+
+  void AddScript(AMXRef amx, const std::string &name);
+  void RemoveScript(AMXRef amx);
+
+  // Returns false if the call is not profiled (the script is unknown or this
+  // is not the main thread); EndPublic() must be called only if it returns
+  // true.
+  bool BeginPublic(AMXRef amx, int index);
+  void EndPublic();
+
+  // Finishes the current tick and starts a new one. Returns true if the
+  // finished tick went over budget.
+  bool EndTick();
+
+  // Time spent in all scripts or in the specified script during the last
+  // finished tick.
+  std::chrono::microseconds last_tick_time() const { return last_tick_time_; }
+  std::chrono::microseconds GetLastTickTime(AMXRef amx) const;
+
+  // Prints where the time of the last finished tick went, most expensive
+  // publics first.
+  void PrintReport(std::ostream &stream) const;
+  void PrintHistogram(std::ostream &stream) const;
+
+  static TickProfiler &shared();
+
+ private:
+  struct Script;
+
+  struct Counter {
+    Script *script;
+    int index;
+    Clock::duration time;
+    Clock::duration inclusive_time;
+    int num_calls;
+    // Number of active calls; only the outermost one counts towards the
+    // inclusive time of recursive publics.
+    int depth;
+  };
+
+  struct Activation {
+    Counter *counter;
+    Clock::time_point start_time;
+  };
+
+  struct Script {
+    explicit Script(AMXRef amx);
+
+    std::string name;
+    AMXRef amx;
+    // Indexed by public index + 2 to fit AMX_EXEC_MAIN and AMX_EXEC_CONT.
+    std::vector<Counter> publics;
+    Clock::duration time;
+    Clock::duration last_tick_time;
+  };
+
+  struct ReportEntry {
+    const Script *script;
+    int index;
+    Clock::duration time;
+    Clock::duration inclusive_time;
+    int num_calls;
+  };
+
+  TickProfiler();
+
+  TickProfiler(const TickProfiler &);
+  TickProfiler &operator=(const TickProfiler &);
+
+  bool IsMainThread() const;
+  void ChargeCurrent(Clock::time_point now);
+
+ private:
+  std::chrono::microseconds budget_;
+  std::thread::id main_thread_id_;
+  std::map<AMX*, std::unique_ptr<Script>> scripts_;
+  std::vector<Activation> active_;
+  std::vector<Counter*> touched_;
+  std::vector<ReportEntry> last_report_;
+  Clock::time_point last_event_time_;
+  std::chrono::microseconds last_tick_time_;
+  long long histogram_[kNumHistogramBuckets];
+  long long num_ticks_;
+  long long num_ticks_over_budget_;
+};
+
+#endif // !TICKPROFILER_H
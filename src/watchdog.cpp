@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include "watchdog.h"
+
+Watchdog::Watchdog()
+  : progress_(0),
+    paused_(0),
+    timeout_(0),
+    stopping_(false)
+{
+}
+
+Watchdog::~Watchdog() {
+  Stop();
+}
+
+void Watchdog::Start(std::chrono::milliseconds timeout, Callback on_timeout) {
+  Stop();
+  timeout_ = timeout;
+  on_timeout_ = on_timeout;
+  stopping_ = false;
+  thread_ = std::thread(&Watchdog::Run, this);
+}
+
+void Watchdog::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  stop_.notify_all();
+  thread_.join();
+}
+
+void Watchdog::Run() {
+  typedef std::chrono::steady_clock Clock;
+
+  // Check a few times per timeout period so that hangs are noticed soon
+  // after the timeout expires.
+  std::chrono::milliseconds interval =
+    std::max(timeout_ / 4, std::chrono::milliseconds(1));
+  unsigned long last_progress = progress_.load(std::memory_order_relaxed);
+  Clock::time_point last_change = Clock::now();
+  bool armed = false;
+  bool fired = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_.wait_for(lock, interval, [this] { return stopping_; })) {
+    unsigned long progress = progress_.load(std::memory_order_relaxed);
+    Clock::time_point now = Clock::now();
+    if (paused_.load(std::memory_order_relaxed) > 0) {
+      last_change = now;
+    } else if (progress != last_progress) {
+      last_progress = progress;
+      last_change = now;
+      armed = true;
+      fired = false;
+    } else if (armed && !fired && now - last_change >= timeout_) {
+      fired = true;
+      lock.unlock();
+      on_timeout_();
+      lock.lock();
+    }
+  }
+}
+
+// static
+Watchdog &Watchdog::shared() {
+  static Watchdog instance;
+  return instance;
+}
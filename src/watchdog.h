@@ -0,0 +1,82 @@
+// Copyright (c) 2026 Zeex
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Calls a function from a background thread when the watched thread stops
+// making progress, i.e. doesn't call Feed() for longer than the timeout.
+// The function is called once per hang; the watchdog re-arms itself when
+// progress resumes. Nothing happens until the first Feed() so that slow
+// server startup is not reported as a hang.
+//
+// The watchdog can be paused while the thread is legitimately blocked, e.g.
+// at a debugger breakpoint.
+class Watchdog {
+ public:
+  typedef std::function<void()> Callback;
+
+  ~Watchdog();
+
+  bool IsRunning() const { return thread_.joinable(); }
+
+  void Start(std::chrono::milliseconds timeout, Callback on_timeout);
+  void Stop();
+
+  void Feed() { progress_.fetch_add(1, std::memory_order_relaxed); }
+
+  void Pause() { paused_.fetch_add(1, std::memory_order_relaxed); }
+  void Resume() {
+    paused_.fetch_sub(1, std::memory_order_relaxed);
+    Feed();
+  }
+
+  static Watchdog &shared();
+
+ private:
+  Watchdog();
+  Watchdog(const Watchdog &) = delete;
+  Watchdog &operator=(const Watchdog &) = delete;
+
+  void Run();
+
+ private:
+  std::atomic<unsigned long> progress_;
+  std::atomic<int> paused_;
+  std::chrono::milliseconds timeout_;
+  Callback on_timeout_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_;
+  bool stopping_;
+};
+
+#endif // !WATCHDOG_H
@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2026 Zeex
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# Splits the debug info off a compiled script. The stripped script is written
+# without the debug section and the AMX_FLAG_DEBUG flag; the debug info goes to
+# <output>.dbg, which CrashDetect loads when the script itself has no debug
+# info. The .dbg file records a hash of the code section, so it's only used
+# with the exact script it was split from.
+
+import argparse
+import struct
+import sys
+
+AMX_HEADER = struct.Struct('<iHBBHh11i')
+AMX_MAGIC = 0xf1e0
+AMX_FLAG_DEBUG = 0x02
+DETACHED_RECORD = struct.Struct('<4sIQ')
+DETACHED_MAGIC = b'CDBG'
+
+def code_hash(data, cod, dat, size):
+  # 64-bit FNV-1a, same as AMXDebugInfo::GetCodeHash().
+  hash = 14695981039346656037
+  for byte in bytearray(data[cod:min(dat, size)]):
+    hash = ((hash ^ byte) * 1099511628211) & 0xffffffffffffffff
+  return hash
+
+def main(argv):
+  arg_parser = argparse.ArgumentParser(
+    description='Split debug info off a compiled Pawn script')
+  arg_parser.add_argument('input', help='script compiled with debug info')
+  arg_parser.add_argument('-o', '--output',
+                          help='stripped script (default: overwrite input)')
+  args = arg_parser.parse_args(argv[1:])
+  output = args.output or args.input
+
+  with open(args.input, 'rb') as file:
+    data = file.read()
+
+  if len(data) < AMX_HEADER.size:
+    sys.exit('%s: not an AMX file' % args.input)
+  header = list(AMX_HEADER.unpack_from(data))
+  size, magic, flags, cod, dat = (header[0], header[1], header[4],
+                                  header[6], header[7])
+  if magic != AMX_MAGIC:
+    sys.exit('%s: not a 32-bit AMX file' % args.input)
+  if not flags & AMX_FLAG_DEBUG or size >= len(data):
+    sys.exit('%s: no debug info' % args.input)
+
+  # The stripped script is the original minus everything after its size.
+  stripped_header = list(header)
+  stripped_header[4] = flags & ~AMX_FLAG_DEBUG
+  stripped = AMX_HEADER.pack(*stripped_header) + data[AMX_HEADER.size:size]
+
+  # The debug file keeps the original header, with the size pointing past
+  # the detached record to where the debug info starts.
+  debug_header = list(header)
+  debug_header[0] = AMX_HEADER.size + DETACHED_RECORD.size
+  record = DETACHED_RECORD.pack(DETACHED_MAGIC, 0,
+                                code_hash(data, cod, dat, size))
+  debug = AMX_HEADER.pack(*debug_header) + record + data[size:]
+
+  with open(output, 'wb') as file:
+    file.write(stripped)
+  with open(output + '.dbg', 'wb') as file:
+    file.write(debug)
+
+  print('%s: %d bytes, %s.dbg: %d bytes' % (output, len(stripped), output,
+                                            len(debug)))
+
+if __name__ == '__main__':
+  main(sys.argv)